@@ -1,3 +1,4 @@
 #!/bin/bash
 unlink gpuline.jacobian.data.bin 2>/dev/null; ln -sf ./$1/gpuline.jacobian.data.bin
 unlink gpuline.mesh.data.bin     2>/dev/null; ln -sf ./$1/gpuline.mesh.data.bin
+unlink gpuline.data.tbk          2>/dev/null; [ -e ./$1/gpuline.data.tbk ] && ln -sf ./$1/gpuline.data.tbk
@@ -0,0 +1,52 @@
+/**
+ * File:   Autotuner.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef AUTOTUNER_HXX
+#define AUTOTUNER_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "Options.hxx"
+
+/**
+ * Kernel variant autotuner (tune=1). The first run for a (device, NVAR,
+ * mesh signature) key times every eligible line-kernel variant on the
+ * loaded Jacobian (factor + solve/update/residual sweeps), rejects any
+ * whose dU differs from the reference kernels (unroll=0), then tunes the
+ * vector kernel launch size (vec_block) for the winner. The result is
+ * stored as solver options in a tuning database next to the OCCA cache
+ * directory; later runs with the same key take it from there directly.
+ */
+class Autotuner {
+  public:
+    Platform &gpu;
+    Mesh &mesh;
+    Jacobian &Jac;
+
+    std::string file;   /**< tuning database */
+    std::string key;    /**< device/NVAR/mesh signature */
+    int reps;           /**< timed sweeps per variant */
+    int force;          /**< 1: ignore the database entry (tune=2) */
+
+    /* constructors */
+    Autotuner(Platform &_gpu,Mesh &_mesh,Jacobian &_Jac,const Options &opts);
+   ~Autotuner(){};
+
+    /* methods */
+    void apply(Options &opts);
+
+  private:
+    std::vector<std::string> variants() const;
+    double trial(const Options &opts,std::vector<double> &dU);
+    bool lookup(std::string &settings) const;
+    void store(const std::string &settings,double time) const;
+};
+
+#endif /* AUTOTUNER_HXX */
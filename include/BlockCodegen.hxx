@@ -0,0 +1,45 @@
+/**
+ * File:   BlockCodegen.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef BLOCKCODEGEN_HXX
+#define BLOCKCODEGEN_HXX
+
+/* header files */
+#include "core.hxx"
+
+/**
+ * Host-side emission of NVAR-specialized block operations. For the block
+ * sizes we run (5, 7, 9, 13 species) the LU factorization, the LU solve
+ * and the row-times-vector product are written out fully unrolled with
+ * literal offsets and register temporaries, and passed to the kernels as
+ * function-like macros in kernelProps["defines"]:
+ *   blockLU(A)            in-place LU (no pivoting) of a column-major block
+ *   blockSolveLU(A,b,x)   x = A^(-1)*b, A LU-factored
+ *   blockRowDot(M,i,x)    sum_j M(i,j)*x[j]
+ * and p_Unrolled is defined. Kernels that use these operations carry a
+ * generic loop version under #ifndef p_Unrolled, which is the fallback
+ * for every other block size. The unrolled code keeps the operation
+ * order of the generic loops, so both give the same result.
+ */
+class BlockCodegen {
+  public:
+    /* block size has an unrolled specialization */
+    static bool specialized(int nvar);
+
+    /* (macro signature, body) pairs; empty when !specialized(nvar) */
+    static std::vector<std::pair<std::string,std::string>> macros(int nvar);
+
+    /* add the macros (and p_Unrolled) to the kernel defines */
+    static void define(occa::properties &props,int nvar);
+
+  private:
+    static std::string LU(int nvar);
+    static std::string solveLU(int nvar);
+    static std::string rowDot(int nvar);
+};
+
+#endif /* BLOCKCODEGEN_HXX */
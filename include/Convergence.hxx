@@ -0,0 +1,82 @@
+/**
+ * File:   Convergence.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef CONVERGENCE_HXX
+#define CONVERGENCE_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "Options.hxx"
+
+/* convergence status */
+#define CONV_RUNNING   0
+#define CONV_CONVERGED 1
+#define CONV_DIVERGED  2
+#define CONV_MAXITER   3
+
+/**
+ * Residual norm monitor: L2 and Linf of the linear residual are reduced
+ * on the device every checkEvery iterations and copied back asynchronously.
+ * A check only waits on the previous check's copy, so the host decides to
+ * stop one check interval late and never drains the stream each sweep.
+ * With several MPI ranks the norms are reduced over all ranks on the host.
+ */
+class Convergence {
+  public:
+    Platform &gpu;
+
+    int checkEvery; /**< iterations between norm checks */
+    double tolAbs;  /**< stop when ||r||_2 <= tolAbs */
+    double tolRel;  /**< stop when ||r||_2 <= tolRel*||r0||_2 */
+    double tolDiv;  /**< diverged when ||r||_2 > tolDiv*||r0||_2 */
+    int status;
+
+    /* history: one entry per evaluated check */
+    std::vector<int> histIter;
+    std::vector<double> histL2;
+    std::vector<double> histLinf;
+
+    occa::kernel normPartial;
+    occa::kernel normFinal;
+    occa::memory o_partial;
+    occa::memory o_hist;
+    occa::memory h_hist;
+
+    /* constructors */
+    Convergence(Platform &_gpu,const Options &opts):
+        gpu(_gpu),status(CONV_RUNNING),
+        N(0),nblocks(0),maxIter(0),maxChecks(0),hist(nullptr)
+    {
+        checkEvery = std::max(1,opts.getInt("check_every",1));
+        tolAbs     = opts.getDouble("tol_abs",0.0);
+        tolRel     = opts.getDouble("tol_rel",0.0);
+        tolDiv     = opts.getDouble("tol_div",1.0e8);
+    }
+   ~Convergence(){};
+
+    /* methods */
+    void setup(size_t nres,int maxIters);
+    bool check(int iter,occa::memory &o_res);
+    void finish();
+    void printHistory() const;
+
+    static const char *statusName(int status);
+
+  private:
+    int N;
+    int nblocks;
+    int maxIter;
+    int maxChecks;
+    double *hist;
+    std::vector<int> queuedIter;
+    std::vector<occa::streamTag> queuedTag;
+
+    void evaluate(int c);
+};
+
+#endif /* CONVERGENCE_HXX */
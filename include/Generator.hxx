@@ -0,0 +1,73 @@
+/**
+ * File:   Generator.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef GENERATOR_HXX
+#define GENERATOR_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "Options.hxx"
+
+/* grid types */
+#define GEN_STRUCTURED     0 /**< every column split into lines */
+#define GEN_BOUNDARY_LAYER 1 /**< one wall line per column, point-Jacobi outside */
+
+/**
+ * Synthetic line systems for scaling studies (gen=structured|bl).
+ * Builds an ni x nj quad grid: i runs along the lines (wall-normal),
+ * j across them. Line lengths are drawn from [line_min,line_max] with
+ * a skew (1: uniform, >1: mostly short lines). Blocks are random with
+ * in-line faces scaled by aniso and every diagonal entry set to
+ * dominance times its off-diagonal row sum (>1: diagonally dominant).
+ * Every value derives from a hash of (seed, record, index), so a run
+ * is reproducible at any size and thread count. The records are written
+ * as the legacy file pair or a TriBlock file, or handed to Mesh and
+ * Jacobian as in-place views (the Generator must outlive them).
+ */
+class Generator {
+  public:
+    int grid;
+    int ni,nj;
+    int lineMin,lineMax;
+    double skew;
+    double dominance;
+    double aniso;
+    int shuffle;            /**< 1: random element numbering */
+    unsigned long long seed;
+
+    /* 0-based records (boundary faces: -2, -3, ... as in the solver files) */
+    int nvar;
+    int nelem,nintface,eftot;
+    int nline,nlineelem,max_line_nelem;
+    std::vector<int> epoint,ef,fc;
+    std::vector<int> linesize,linepoint,lines,lineface;
+    std::vector<double> jacD,jacO1,jacO2,rhs;
+
+    /* constructors */
+    Generator(const Options &opts);
+   ~Generator(){};
+
+    /* methods */
+    void generateMesh();
+    void generateBlocks(int _nvar);
+    void toMesh(Mesh &mesh);
+    void toJacobian(Jacobian &Jac);
+    bool writeLegacy(const std::string &meshName,const std::string &jacName) const;
+    bool writeTriBlock(const std::string &fileName) const;
+    std::string name() const;
+
+    static std::vector<double> batchRhs(const Jacobian &Jac,int nrhs);
+
+  private:
+    std::vector<char> inline_face; /**< [nintface] 1: face couples a line */
+
+    double uniform(int stream,size_t index) const;
+};
+
+#endif /* GENERATOR_HXX */
@@ -12,18 +12,13 @@
 #include "core.hxx"
 #include "Mesh.hxx"
 #include "Platform.hxx"
+#include "MappedFile.hxx"
+#include "Transfer.hxx"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* ================== */
-/* External Functions */
-/* ================== */
-void read_jacobian_data_(int *nvar,int *nelem,int *nintface,
-                         double *jacD,double *jacO1,double *jacO2,
-                         double *rhs,double *U0);
-
 class bcsr_matrix {
   public:
     int nrows;  /**< number of matrix rows */
@@ -43,23 +38,28 @@ class bcsr_matrix {
 class Jacobian {
   public:
     size_t nbytes;
+    int lowmem;     /**< 1: no device jacD/A/U0, see setupDevice */
+    int nrhs;       /**< right-hand sides per solve: vectors are (nvar,nrhs,nelem) */
 
     /* variables */
     int nvar;
     int nelem;
     int nintface;
 
+    /* file-backed data: views of the mapped file until resized */
+    MappedFile jacFile;
+    HostArray<double> jacD;
+    HostArray<double> jacO1;
+    HostArray<double> jacO2;
+    HostArray<double> rhs;
+    HostArray<double> U0;
+
     std::vector<double> jacDLU;
-    std::vector<double> jacD;
-    std::vector<double> jacO1;
-    std::vector<double> jacO2;
-    std::vector<double> rhs;
     std::vector<double> res;
     std::vector<double> U;
-    std::vector<double> U0;
     std::vector<double> dU;
 
-    std::vector<double> A;
+    HostArray<double> A;
     std::vector<double> DinvC;
   //std::vector<double> B;
   //std::vector<double> C;
@@ -84,17 +84,37 @@ class Jacobian {
   //occa::memory o_offmap;
 
     /* constructors */
-    Jacobian(){};
+    Jacobian():lowmem(0),nrhs(1){};
    ~Jacobian(){};
 
     /* methods */
-    bool fromFile(int nlineelem);
+    bool fromFile(int nlineelem,const std::string &fileName = "gpuline.jacobian.data.bin");
+    bool fromTriBlockFile(int nlineelem);
+    void fromArrays(int _nvar,int _nelem,int _nintface,
+                    const double *D,const double *O1,const double *O2,const double *b);
+    void wrapDevice(Platform &gpu,int _nvar,int _nelem,int _nintface,
+                    occa::memory &o_D,occa::memory &o_O1,occa::memory &o_O2,occa::memory &o_b);
+    void allocate(int nlineelem);
+    void printStats();
     void assembleTriBlocks(Mesh &mesh);
     void assembleCSR(Mesh &mesh);
     void resizeBlockSize(int nvar_new);
+    void reorderLines(const Mesh &mesh);
+    void setNrhs(int nrhs_new,const double *B);
+    void updateBlocks(const std::vector<int> &elems,const std::vector<int> &faces);
+    void repackTriBlocks(const Mesh &mesh,const std::vector<int> &elems);
+    void restoreDiag(const std::vector<int> &elems);
     void setupDevice(Platform &gpu);
+    size_t lowmemSavedBytes() const;
     void toDevice();
     void fromDevice();
+
+    /* asynchronous transfers through pinned staging (see Transfer) */
+    void toDevice(Transfer &xfer);
+    void blocksToDevice(Transfer &xfer,int p,int nparts);
+    void vectorsToDevice(Transfer &xfer);
+    void downloadSolution(Transfer &xfer);
+    void fromDevice(Transfer &xfer);
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,69 @@
+/**
+ * File:   KernelCache.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef KERNELCACHE_HXX
+#define KERNELCACHE_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "Options.hxx"
+
+/* system header files */
+#include <thread>
+
+/* manifest of AOT-built combinations, inside the OCCA cache directory */
+#define KERNEL_MANIFEST_NAME "triblock_kernels.manifest"
+
+/**
+ * Warm kernel cache. triblock_aot.exe (CMake target triblock_aot)
+ * compiles the default kernel set for configured (mode, NVAR,
+ * MAX_LINE_ELEM) combinations into an OCCA cache directory and records
+ * each combination in its manifest; point OCCA_CACHE_DIR at that
+ * directory to deploy it. At startup a manifest hit on every rank marks
+ * the Platform warm: kernels are loaded from the cached binaries without
+ * the root-first build barriers. On a miss, rank 0 compiles the set on a
+ * private device in a background thread while the Jacobian is read and
+ * uploaded; LineSolver::setup then finds the binaries cached, and the
+ * combination is recorded for later runs.
+ */
+class KernelCache {
+  public:
+    struct Spec {
+        std::string file;
+        std::string name;
+        occa::properties props;
+    };
+
+    Platform &gpu;
+    std::string manifest;
+
+    /* constructors */
+    KernelCache(Platform &_gpu);
+   ~KernelCache(){wait();};
+
+    /* methods */
+    bool warm(int nvar,int maxLineElem,const Options &opts);
+    void prefetch(int nvar,int maxLineElem,const Options &opts);
+    void wait();
+
+    /* default-path kernels: LineSolver (fp64, single and multi-rank) + Convergence */
+    static std::vector<Spec> kernelSet(int nvar,int maxLineElem,const Options &opts);
+    static std::string comboKey(occa::device &device,int nvar,int maxLineElem,const Options &opts);
+
+    /* compile specs on device and append key to the manifest */
+    static void build(occa::device &device,const std::vector<Spec> &specs,
+                      const std::string &manifest,const std::string &key);
+    static std::string manifestPath(const std::string &cacheDir);
+
+  private:
+    std::thread worker;
+
+    static bool listed(const std::string &manifest,const std::string &key);
+};
+
+#endif /* KERNELCACHE_HXX */
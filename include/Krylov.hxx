@@ -0,0 +1,86 @@
+/**
+ * File:   Krylov.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef KRYLOV_HXX
+#define KRYLOV_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "LineSolver.hxx"
+#include "Options.hxx"
+
+/**
+ * Restarted, right-preconditioned GMRES on J*U = -rhs (FGMRES when
+ * flexible=1). The operator is the line residual kernel (r += J*x),
+ * the preconditioner pcSweeps line-implicit Jacobi sweeps from zero.
+ * Arnoldi vectors stay on the device; each step orthogonalizes with
+ * two classical Gram-Schmidt passes (CGS2) of fused dot products and
+ * only the Hessenberg column is copied back.
+ */
+class Krylov {
+  public:
+    Platform &gpu;
+    LineSolver &solver;
+
+    int restart;    /**< Krylov subspace dimension per cycle */
+    int flexible;   /**< 1: store Z = M^(-1)*V (FGMRES) */
+    int pcSweeps;   /**< line-Jacobi sweeps per preconditioner application */
+    double tolAbs;
+    double tolRel;
+
+    int niter;      /**< Arnoldi steps taken */
+    int nprec;      /**< preconditioner applications */
+    bool converged;
+    double resNorm; /**< true ||r||_2 at exit */
+    std::vector<double> history; /**< residual estimate per Arnoldi step */
+
+    occa::kernel krylovSet;
+    occa::kernel krylovScale;
+    occa::kernel krylovAxpy;
+    occa::kernel krylovDots;
+    occa::kernel krylovDotsFinal;
+    occa::kernel krylovCombine;
+
+    occa::memory o_V;       /**< [N*(restart+1)] Arnoldi basis */
+    occa::memory o_Z;       /**< [N*restart] preconditioned basis (flexible) */
+    occa::memory o_z;
+    occa::memory o_t;
+    occa::memory o_pres;
+    occa::memory o_pdU;
+    occa::memory o_partial;
+    occa::memory o_h;       /**< [2*(restart+1)+1] CGS2 passes and norm */
+
+    /* constructors */
+    Krylov(Platform &_gpu,LineSolver &_solver,const Options &opts):
+        gpu(_gpu),solver(_solver),
+        niter(0),nprec(0),converged(false),resNorm(0.0),N(0),nblocks(0),nkrylov(0)
+    {
+        flexible = (opts.getString("solver","jacobi") == "fgmres");
+        restart  = opts.getInt("restart",30);
+        pcSweeps = std::max(1,opts.getInt("pc_sweeps",1));
+        tolAbs   = opts.getDouble("tol_abs",0.0);
+        tolRel   = opts.getDouble("tol_rel",0.0);
+    }
+   ~Krylov(){};
+
+    /* methods */
+    void setup();
+    int solve(int maxIters);
+
+  private:
+    int N;
+    int nblocks;
+    int nkrylov;
+
+    occa::memory col(occa::memory &o_basis,int i);
+    double norm(occa::memory &o_x);
+    void precondition(occa::memory o_v,occa::memory o_zout);
+    void orthogonalize(int k,occa::memory &o_w,std::vector<double> &h);
+};
+
+#endif /* KRYLOV_HXX */
@@ -0,0 +1,180 @@
+/**
+ * File:   LineSolver.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef LINESOLVER_HXX
+#define LINESOLVER_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "Platform.hxx"
+#include "Partition.hxx"
+#include "NativeEngine.hxx"
+#include "BlockCodegen.hxx"
+#include "Transfer.hxx"
+#include "Options.hxx"
+
+/* factored block storage precision */
+#define PRECISION_FP64 0
+#define PRECISION_FP32 1
+#define PRECISION_BF16 2
+#define PRECISION_FP16 3
+
+/**
+ * Line-implicit Jacobi solver: owns the device kernels and dispatches
+ * the factor/solve/residual phases for the selected mode.
+ */
+class LineSolver {
+  public:
+    Platform &gpu;
+    Mesh &mesh;
+    Jacobian &Jac;
+    Partition *part;  /**< MPI runs: halo exchange + split residual (nullptr: off) */
+
+    int precision;
+    int fused;      /**< 1: fused solve/update/residual sweep */
+    int nlinesBlock;/**< >0: batched kernels with this many lines per block */
+    int crMin;      /**< >0: lines with at least crMin elements use cyclic reduction */
+    int schedule;   /**< 1: length-binned launches (Mesh::buildSchedule) */
+    int lowmem;     /**< 1: no device jacD/A copies (Jacobian::lowmem) */
+    int adjoint;    /**< 1: build transposed solve/residual (solveT/residualT) */
+    int nrhs;       /**< >1: batched kernels over (NVAR,nrhs,nelem) vectors */
+    int factorReuse;/**< keep stale factors for up to K Jacobian updates */
+    int staleUpdates;
+    int native;     /**< 1: NATIVE_MODE host engine for factor/solve/residual */
+    int unroll;     /**< 1: NVAR-specialized factor/solve/residual kernels (BlockCodegen) */
+    int vecBlock;   /**< threads per block of the vector utility kernels */
+    int uploadParts;/**< factor(Transfer&): block upload parts (0: by size) */
+    int ncr;
+    int ncrrow;
+    int njac;
+    occa::properties kernelProps;
+
+    /* native CPU engine (NATIVE_MODE) */
+    NativeEngine *engine;
+
+    /* utility kernels */
+    occa::kernel copyAtoBjac;
+    occa::kernel copyAtoB;
+    occa::kernel addAtoB;
+
+    /* line factorization, solve, and residual */
+    occa::kernel lineLU;
+    occa::kernel solveDU;
+    occa::kernel lineRes;
+
+    /* mixed precision */
+    occa::kernel packBlocks;
+    occa::kernel solveDU_lp;
+
+    occa::memory o_lpDia;
+    occa::memory o_lpDinvC;
+    occa::memory o_lpA;
+    occa::memory o_sDia;
+    occa::memory o_sDinvC;
+    occa::memory o_sA;
+
+    /* batched line bins (binNlines[b] lines x NVAR^2 threads per block) */
+    std::vector<int> binNlines;
+    std::vector<int> binNbatch;
+    std::vector<occa::kernel> binLU;
+    std::vector<occa::kernel> binSolve;
+    std::vector<occa::memory> o_binlist;
+    std::vector<std::string> binLUName;    /**< profile scope names, e.g. lineLU[17-32] */
+    std::vector<std::string> binSolveName;
+
+    /* length-1 lines: pointwise Jacobi */
+    occa::kernel jacobiLU;
+    occa::kernel jacobiDU;
+    occa::memory o_jacelem;
+
+    /* block cyclic reduction for long lines */
+    occa::kernel crFactor;
+    occa::kernel crSolveDU;
+    occa::memory o_crlist;
+    occa::memory o_crpoint;
+    occa::memory o_crA;
+    occa::memory o_crC;
+
+    /* adjoint: J^T*lambda = g with the forward factors */
+    occa::kernel solveDUT;
+    occa::kernel lineResT;
+
+    /* incremental refactorization of dirty lines */
+    occa::kernel lineCopyList;
+    occa::kernel lineLUList;
+    occa::memory o_dirtylines;
+    std::vector<char> dirtyLine;
+
+    /* fused iteration */
+    occa::kernel solveDU_fused;
+    occa::kernel lineResOffLine;
+
+    /* constructors */
+    LineSolver(Platform &_gpu,Mesh &_mesh,Jacobian &_Jac,const Options &opts):
+        gpu(_gpu),mesh(_mesh),Jac(_Jac),part(nullptr),
+        staleUpdates(0),native(0),ncr(0),ncrrow(0),njac(0)
+    {
+        precision   = findPrecision(opts.getString("precision","fp64"));
+        fused       = opts.getInt("fused",0);
+        nlinesBlock = opts.getInt("lines_per_block",0);
+        crMin       = opts.getInt("cr_min",0);
+        schedule    = opts.getInt("schedule",0);
+        lowmem      = Jac.lowmem;
+        adjoint     = opts.getInt("adjoint",0);
+        nrhs        = Jac.nrhs;
+        factorReuse = opts.getInt("factor_reuse",0);
+        unroll      = opts.getInt("unroll",1);
+        vecBlock    = opts.getInt("vec_block",256);
+        uploadParts = opts.getInt("upload_parts",0);
+        engine      = nullptr;
+    }
+   ~LineSolver(){delete engine;};
+
+    /* methods */
+    std::string check() const;
+    void setup();
+    void factor();
+    void factor(Transfer &xfer);
+    void reset();
+    void solve();
+    void update();
+    void residual();
+
+    /* incremental update after the host blocks of elems/faces changed;
+     * returns the number of lines refactored (0: stale factors reused) */
+    int updateJacobian(const std::vector<int> &elems,const std::vector<int> &faces);
+
+    /* dU = M^(-1)*(-r) and r += J*U on caller vectors */
+    void solve(occa::memory &o_dU,occa::memory &o_res);
+    void residual(occa::memory &o_U,occa::memory &o_res);
+    void solveT(occa::memory &o_dU,occa::memory &o_res);
+    void residualT(occa::memory &o_U,occa::memory &o_res);
+
+    /* bytes moved per call (bandwidth model) */
+    double factorBytes() const;
+    double solveBytes() const;
+    double updateBytes() const;
+    double resetBytes() const;
+    double residualBytes() const;
+
+    /* NVAR/MAX_LINE_ELEM defines of every kernel (setup, KernelCache) */
+    static occa::properties baseProperties(int nvar,int maxLineElem);
+
+    static int findPrecision(const std::string &name);  /**< -1: unknown */
+    static int parsePrecision(const std::string &name);
+    static const char *precisionName(int precision);
+
+  private:
+    size_t storageBytes() const;
+    void packFactors();
+    int refactorDirty();
+    void addBin(std::vector<int> &group,int nlines);
+};
+
+#endif /* LINESOLVER_HXX */
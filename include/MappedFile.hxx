@@ -0,0 +1,122 @@
+/**
+ * File:   MappedFile.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef MAPPEDFILE_HXX
+#define MAPPEDFILE_HXX
+
+/* header files */
+#include "core.hxx"
+
+/* system header files */
+#include <algorithm>
+
+/* device upload chunk size (bytes) when staging from mapped pages */
+#define MAPPED_CHUNK_BYTES (64*1024*1024)
+
+/**
+ * Read-only view of a binary file mapped into the address space.
+ * The mapping is private and writable: pages are shared with the page
+ * cache until written, at which point the kernel copies them (the file
+ * itself is never modified).
+ */
+class MappedFile {
+  public:
+    /* constructors */
+    MappedFile(){};
+   ~MappedFile(){close();}
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /* methods */
+    bool open(const std::string &fileName);
+    void close();
+    void prefetch(const void *addr,size_t bytes) const;
+
+    bool isOpen() const {return base != nullptr;}
+    size_t size() const {return nbytes;}
+    const std::string &name() const {return fname;}
+
+    template <class T>
+    T *ptr(size_t offset) const {
+        return reinterpret_cast<T*>(base + offset);
+    }
+
+  private:
+    char *base = nullptr;
+    size_t nbytes = 0;
+    std::string fname;
+};
+
+/**
+ * Host array which either owns its storage or views external memory
+ * (e.g. a section of a MappedFile). Views are promoted to owned storage
+ * on resize, so callers may treat it like a std::vector.
+ */
+template <class T>
+class HostArray {
+  public:
+    /* constructors */
+    HostArray(){};
+   ~HostArray(){};
+
+    /* methods */
+    void wrap(T *src,size_t count){
+        store.clear();
+        store.shrink_to_fit();
+        view = src;
+        nview = count;
+    }
+
+    void resize(size_t count){
+        if(view){
+            store.assign(view, view + std::min(count,nview));
+            view = nullptr;
+            nview = 0;
+        }
+        store.resize(count);
+    }
+
+    bool isView() const {return view != nullptr;}
+
+    T *data() {return view ? view : store.data();}
+    const T *data() const {return view ? view : store.data();}
+    size_t size() const {return view ? nview : store.size();}
+
+    T *begin() {return data();}
+    T *end() {return data() + size();}
+    const T *begin() const {return data();}
+    const T *end() const {return data() + size();}
+
+    T &operator[](size_t i) {return data()[i];}
+    const T &operator[](size_t i) const {return data()[i];}
+
+  private:
+    std::vector<T> store;
+    T *view = nullptr;
+    size_t nview = 0;
+};
+
+/* upload host memory to the device in chunks, prefetching the next chunk */
+template <class T>
+void uploadChunked(occa::memory &o_mem,const T *src,size_t count,
+                   const MappedFile *file = nullptr){
+    const size_t chunk = MAPPED_CHUNK_BYTES/sizeof(T);
+
+    if(file) file->prefetch(src,std::min(chunk,count)*sizeof(T));
+    for(size_t offset = 0; offset < count; offset += chunk){
+        const size_t n = std::min(chunk,count-offset);
+        const size_t next = offset + n;
+
+        if(file && next < count){
+            file->prefetch(src+next,std::min(chunk,count-next)*sizeof(T));
+        }
+        o_mem.copyFrom(src+offset,n,offset);
+    }
+}
+
+#endif /* MAPPEDFILE_HXX */
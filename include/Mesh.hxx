@@ -11,19 +11,13 @@
 /* header files */
 #include "core.hxx"
 #include "Platform.hxx"
+#include "MappedFile.hxx"
+#include "Transfer.hxx"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* ================== */
-/* External Functions */
-/* ================== */
-void read_mesh_data_(int *nvar,int *nelem,int *nintface,
-                     int *eftot,int *nline,int *nlineelem,
-                     int *epoint,int *ef,int *fc,int *lines,
-                     int *linesize,int *linepoint,int *lineface);
-
 class Mesh {
   public:
     size_t nbytes;
@@ -38,14 +32,33 @@ class Mesh {
     int nlineelem;
     int max_line_nelem;
 
-    std::vector<int> epoint;
-    std::vector<int> ef;
-    std::vector<int> fc;
+    MappedFile meshFile;
+    HostArray<int> epoint;
+    HostArray<int> ef;
+    HostArray<int> fc;
+
+    HostArray<int> lines;
+    HostArray<int> linesize;
+    HostArray<int> lineface;
+    HostArray<int> linepoint;
+
+    HostArray<int> elemperm; /**< line-ordered files: element -> original element */
+
+    /* line-ordered layout (reorderLines): element ids become storage slots */
+    int interleave;               /**< 0: native order, W: k-th blocks of W lines adjacent */
+    int nelem_native;
+    std::vector<int> elemslot;    /**< [nelem_native] native element -> slot */
+    std::vector<int> slotelem;    /**< [nelem] slot -> native element (-1: padding) */
+
+    /* line schedule: bin b holds lines with 2^b <= length < 2^(b+1) */
+    int nbin;
+    std::vector<int> schedlines; /**< line ids grouped by bin, longest first */
+    std::vector<int> binpoint;   /**< [nbin+1] bin offsets into schedlines */
+    std::vector<int> binmaxlen;  /**< [nbin] longest line in each bin */
 
-    std::vector<int> lines;
-    std::vector<int> linesize;
-    std::vector<int> lineface;
-    std::vector<int> linepoint;
+    /* element -> line lookup (incremental refactorization) */
+    std::vector<int> elemline;   /**< [nelem] line of each element (-1: none) */
+    std::vector<int> elemlinepos;/**< [nelem] index m into lines/lineface */
 
     occa::memory o_epoint;
     occa::memory o_ef;
@@ -56,13 +69,25 @@ class Mesh {
     occa::memory o_linepoint;
 
     /* constructors */
-    Mesh(){};
+    Mesh():interleave(0),nelem_native(0){};
    ~Mesh(){};
 
     /* methods */
-    bool fromFile();
+    bool fromFile(const std::string &fileName = "gpuline.mesh.data.bin");
+    bool fromTriBlockFile();
+    void fromArrays(int _nelem,int _nintface,int _eftot,
+                    const int *_epoint,const int *_ef,const int *_fc,
+                    int _nline,int _nlineelem,const int *_linesize,const int *_linepoint,
+                    const int *_lines,const int *_lineface,int base);
+    void printStats();
+    void buildSchedule();
+    void buildElemLines();
+    void reorderLines(int W);
+    void toNative(int nvar,const double *slotvec,double *nativevec) const;
+    void fromNative(int nvar,const double *nativevec,double *slotvec) const;
     void setupDevice(Platform &gpu);
     void toDevice();
+    void toDevice(Transfer &xfer);
     void fromDevice();
 };
 
@@ -0,0 +1,295 @@
+/**
+ * File:   NativeEngine.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef NATIVEENGINE_HXX
+#define NATIVEENGINE_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Mesh.hxx"
+
+/* system header files */
+#include <algorithm>
+
+/* SIMD lanes = lines processed in lockstep (NativeEngine.cxx is built
+ * with -march=TRIBLOCK_NATIVE_ARCH: query NativeEngine::lanes() elsewhere) */
+#if defined(__AVX512F__)
+#define NATIVE_LANES 8
+#define NATIVE_ISA "AVX-512"
+#elif defined(__AVX2__)
+#define NATIVE_LANES 4
+#define NATIVE_ISA "AVX2"
+#elif defined(__SSE2__)
+#define NATIVE_LANES 4
+#define NATIVE_ISA "SSE2"
+#else
+#define NATIVE_LANES 4
+#define NATIVE_ISA "generic"
+#endif
+
+/* largest block size with a compiled engine */
+#define NATIVE_MAX_NVAR 16
+
+/**
+ * Native CPU line solver (compute mode NATIVE_MODE): host C++ instead of
+ * JIT-compiled GPU-shaped kernels. Device vectors live in OCCA Serial
+ * memory and are passed in as host pointers.
+ */
+class NativeEngine {
+  public:
+    virtual ~NativeEngine(){};
+
+    virtual void factor(const double *jacD,const double *O1,const double *O2) = 0;
+    virtual void solve(double *dU,const double *R) = 0;
+    virtual void residual(const double *jacD,const double *O1,const double *O2,
+                          const double *U,double *R) = 0;
+
+    static NativeEngine *create(int nvar,const Mesh &mesh);
+    static const char *isa();   /**< instruction set the engines were compiled for */
+    static int lanes();
+};
+
+/**
+ * Block Thomas algorithm with W lines in lockstep (one line per SIMD
+ * lane), templated on the block size. Lines are sorted by length and
+ * batched W at a time; each batch is stored interleaved as slabs
+ * [k][block entry][lane], so every block entry is one contiguous W-wide
+ * vector. Short lines are padded with identity diagonals and zero
+ * coupling blocks, which leave the padded lanes at zero. OpenMP runs
+ * over batches.
+ */
+template <int NVAR,int W>
+class NativeLines : public NativeEngine {
+  public:
+    static constexpr int NB = NVAR*NVAR;
+
+    /* constructors */
+    NativeLines(const Mesh &_mesh):mesh(_mesh){
+        std::vector<int> order(mesh.nline);
+        for(int l = 0; l < mesh.nline; ++l) order[l] = l;
+        std::stable_sort(order.begin(),order.end(),
+                         [&](int a,int b){return mesh.linesize[a] > mesh.linesize[b];});
+
+        nbatch = (mesh.nline + W - 1)/W;
+        batchpoint.assign(nbatch+1,0);
+        for(int b = 0; b < nbatch; ++b){
+            batchpoint[b+1] = batchpoint[b] + mesh.linesize[order[W*b]];
+        }
+
+        /* per (slab,lane): element, coupling face and orientation */
+        const int nslab = batchpoint[nbatch];
+        elem.assign((size_t) nslab*W,-1);
+        face.assign((size_t) nslab*W,-1);
+        first.assign((size_t) nslab*W,0);
+        for(int b = 0; b < nbatch; ++b){
+            for(int w = 0; w < W && W*b + w < mesh.nline; ++w){
+                const int l = order[W*b + w];
+                for(int k = 0; k < mesh.linesize[l]; ++k){
+                    const int m = mesh.linepoint[l] + k;
+                    const size_t s = (size_t) W*(batchpoint[b] + k) + w;
+                    elem[s] = mesh.lines[m];
+                    if(k > 0){
+                        face[s] = mesh.lineface[m];
+                        first[s] = (mesh.lines[m] == mesh.fc[2*face[s]]);
+                    }
+                }
+            }
+        }
+
+        Dlu.assign((size_t) nslab*NB*W,0.0);
+        Gam.assign((size_t) nslab*NB*W,0.0);
+        Ab.assign((size_t) nslab*NB*W,0.0);
+    }
+   ~NativeLines(){};
+
+    void factor(const double *jacD,const double *O1,const double *O2) override {
+        #pragma omp parallel for schedule(dynamic)
+        for(int b = 0; b < nbatch; ++b){
+            alignas(64) double C[NB*W];
+
+            for(int s = batchpoint[b]; s < batchpoint[b+1]; ++s){
+                double *D = &Dlu[(size_t) s*NB*W];
+                double *A = &Ab[(size_t) s*NB*W];
+
+                /* gather D, A and C(s-1) of each lane (padding: D = I, A = C = 0) */
+                for(int w = 0; w < W; ++w){
+                    const size_t sw = (size_t) W*s + w;
+                    const int e = elem[sw];
+                    const int f = face[sw];
+                    for(int q = 0; q < NB; ++q){
+                        D[W*q + w] = (e >= 0) ? jacD[(size_t) NB*e + q]:((q % (NVAR+1)) ? 0.0:1.0);
+                        A[W*q + w] = (f >= 0) ? (first[sw] ? O2:O1)[(size_t) NB*f + q]:0.0;
+                        C[W*q + w] = (f >= 0) ? (first[sw] ? O1:O2)[(size_t) NB*f + q]:0.0;
+                    }
+                }
+
+                if(s > batchpoint[b]){
+                    /* Gamma(s-1) = D'(s-1)^(-1)*C, column by column */
+                    double *G = &Gam[(size_t) (s-1)*NB*W];
+                    const double *Dlast = &Dlu[(size_t) (s-1)*NB*W];
+                    for(int c = 0; c < NVAR; ++c){
+                        solveLU(Dlast,&C[W*NVAR*c],&G[W*NVAR*c]);
+                    }
+
+                    /* D'(s) = D(s) - A*Gamma */
+                    for(int c = 0; c < NVAR; ++c){
+                        for(int j = 0; j < NVAR; ++j){
+                            for(int i = 0; i < NVAR; ++i){
+                                #pragma omp simd
+                                for(int w = 0; w < W; ++w){
+                                    D[W*(i + NVAR*c) + w] -= A[W*(i + NVAR*j) + w]*G[W*(j + NVAR*c) + w];
+                                }
+                            }
+                        }
+                    }
+                }
+                LU(D);
+            }
+        }
+    }
+
+    void solve(double *dU,const double *R) override {
+        #pragma omp parallel
+        {
+            std::vector<double> X((size_t) mesh.max_line_nelem*NVAR*W);
+
+            #pragma omp for schedule(dynamic)
+            for(int b = 0; b < nbatch; ++b){
+                const int s0 = batchpoint[b];
+                const int n = batchpoint[b+1] - s0;
+
+                /* forward: X(k) = D'(k)^(-1)*(-R(k) - A(k)*X(k-1)) */
+                for(int k = 0; k < n; ++k){
+                    const int s = s0 + k;
+                    alignas(64) double rhs[NVAR*W];
+                    for(int w = 0; w < W; ++w){
+                        const int e = elem[(size_t) W*s + w];
+                        for(int i = 0; i < NVAR; ++i){
+                            rhs[W*i + w] = (e >= 0) ? -R[(size_t) NVAR*e + i]:0.0;
+                        }
+                    }
+                    if(k > 0) gemv(&Ab[(size_t) s*NB*W],&X[(size_t) (k-1)*NVAR*W],rhs);
+                    solveLU(&Dlu[(size_t) s*NB*W],rhs,&X[(size_t) k*NVAR*W]);
+                }
+
+                /* backward: X(k) -= Gamma(k)*X(k+1) */
+                for(int k = n-2; k >= 0; --k){
+                    gemv(&Gam[(size_t) (s0+k)*NB*W],&X[(size_t) (k+1)*NVAR*W],&X[(size_t) k*NVAR*W]);
+                }
+
+                /* scatter the real lanes */
+                for(int k = 0; k < n; ++k){
+                    for(int w = 0; w < W; ++w){
+                        const int e = elem[(size_t) W*(s0+k) + w];
+                        if(e < 0) continue;
+                        for(int i = 0; i < NVAR; ++i){
+                            dU[(size_t) NVAR*e + i] = X[(size_t) (k*NVAR + i)*W + w];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void residual(const double *jacD,const double *O1,const double *O2,
+                  const double *U,double *R) override {
+        /* R += [D]*U + [O]*U over the line elements */
+        #pragma omp parallel for schedule(static)
+        for(int m = 0; m < mesh.nlineelem; ++m){
+            const int e = mesh.lines[m];
+            double r[NVAR];
+
+            const double *D = &jacD[(size_t) NB*e];
+            const double *u = &U[(size_t) NVAR*e];
+            for(int i = 0; i < NVAR; ++i) r[i] = 0.0;
+            for(int j = 0; j < NVAR; ++j){
+                #pragma omp simd
+                for(int i = 0; i < NVAR; ++i) r[i] += D[i + NVAR*j]*u[j];
+            }
+
+            for(int k = mesh.epoint[e]; k < mesh.epoint[e+1]; ++k){
+                const int f = mesh.ef[k];
+                if(f < 0) continue;
+
+                const int e1 = mesh.fc[2*f+0];
+                const int e2 = mesh.fc[2*f+1];
+                const double *O = (e==e1) ? &O2[(size_t) NB*f]:&O1[(size_t) NB*f];
+                const double *un = &U[(size_t) NVAR*((e==e1) ? e2:e1)];
+                for(int j = 0; j < NVAR; ++j){
+                    #pragma omp simd
+                    for(int i = 0; i < NVAR; ++i) r[i] += O[i + NVAR*j]*un[j];
+                }
+            }
+
+            for(int i = 0; i < NVAR; ++i) R[(size_t) NVAR*e + i] += r[i];
+        }
+    }
+
+  private:
+    const Mesh &mesh;
+    int nbatch;
+    std::vector<int> batchpoint; /**< [nbatch+1] slab offsets */
+    std::vector<int> elem;       /**< [nslab*W] element (-1: padding) */
+    std::vector<int> face;       /**< [nslab*W] face to the previous element */
+    std::vector<char> first;     /**< [nslab*W] element is fc[2*face] */
+    std::vector<double> Dlu;     /**< [nslab][NB][W] factored diagonals */
+    std::vector<double> Gam;     /**< [nslab][NB][W] Gamma = D'^(-1)*C */
+    std::vector<double> Ab;      /**< [nslab][NB][W] sub-diagonal A */
+
+    /* lane-wise LU (no pivoting) of a column-major block */
+    static inline void LU(double *M){
+        for(int j = 0; j < NVAR; ++j){
+            alignas(64) double pivot[W];
+            #pragma omp simd
+            for(int w = 0; w < W; ++w) pivot[w] = 1.0/M[W*(j + NVAR*j) + w];
+
+            for(int i = j+1; i < NVAR; ++i){
+                #pragma omp simd
+                for(int w = 0; w < W; ++w) M[W*(i + NVAR*j) + w] *= pivot[w];
+
+                for(int k = j+1; k < NVAR; ++k){
+                    #pragma omp simd
+                    for(int w = 0; w < W; ++w){
+                        M[W*(i + NVAR*k) + w] -= M[W*(i + NVAR*j) + w]*M[W*(j + NVAR*k) + w];
+                    }
+                }
+            }
+        }
+    }
+
+    /* lane-wise x = M^(-1)*b, M LU-factored */
+    static inline void solveLU(const double *M,const double *b,double *x){
+        for(int i = 0; i < NVAR; ++i){
+            #pragma omp simd
+            for(int w = 0; w < W; ++w) x[W*i + w] = b[W*i + w];
+            for(int j = 0; j < i; ++j){
+                #pragma omp simd
+                for(int w = 0; w < W; ++w) x[W*i + w] -= M[W*(i + NVAR*j) + w]*x[W*j + w];
+            }
+        }
+        for(int i = NVAR-1; i >= 0; --i){
+            for(int j = i+1; j < NVAR; ++j){
+                #pragma omp simd
+                for(int w = 0; w < W; ++w) x[W*i + w] -= M[W*(i + NVAR*j) + w]*x[W*j + w];
+            }
+            #pragma omp simd
+            for(int w = 0; w < W; ++w) x[W*i + w] /= M[W*(i + NVAR*i) + w];
+        }
+    }
+
+    /* lane-wise y -= M*x */
+    static inline void gemv(const double *M,const double *x,double *y){
+        for(int j = 0; j < NVAR; ++j){
+            for(int i = 0; i < NVAR; ++i){
+                #pragma omp simd
+                for(int w = 0; w < W; ++w) y[W*i + w] -= M[W*(i + NVAR*j) + w]*x[W*j + w];
+            }
+        }
+    }
+};
+
+#endif /* NATIVEENGINE_HXX */
@@ -0,0 +1,99 @@
+/**
+ * File:   Options.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef OPTIONS_HXX
+#define OPTIONS_HXX
+
+/* header files */
+#include "core.hxx"
+
+/* system header files */
+#include <map>
+
+/**
+ * Command line options of the form key=value (same convention as
+ * makescript.sh). Arguments without '=' are kept as positional.
+ */
+class Options {
+  public:
+    std::vector<std::string> positional;
+
+    /* constructors */
+    Options(){};
+    Options(int argc,char **argv){
+        for(int i = 1; i < argc; ++i){
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if(eq == std::string::npos){
+                positional.push_back(arg);
+            } else {
+                values[arg.substr(0,eq)] = arg.substr(eq+1);
+            }
+        }
+    }
+
+    /* "key=value key=value ..." (library API) */
+    Options(const std::string &args){
+        std::stringstream ss(args);
+        std::string arg;
+        while(ss >> arg){
+            size_t eq = arg.find('=');
+            if(eq == std::string::npos){
+                positional.push_back(arg);
+            } else {
+                values[arg.substr(0,eq)] = arg.substr(eq+1);
+            }
+        }
+    }
+   ~Options(){};
+
+    /* methods */
+    bool has(const std::string &key) const {
+        return values.count(key) > 0;
+    }
+
+    std::string getString(const std::string &key,const std::string &def) const {
+        auto it = values.find(key);
+        return (it == values.end()) ? def:it->second;
+    }
+
+    int getInt(const std::string &key,int def) const {
+        auto it = values.find(key);
+        return (it == values.end()) ? def:std::stoi(it->second);
+    }
+
+    double getDouble(const std::string &key,double def) const {
+        auto it = values.find(key);
+        return (it == values.end()) ? def:std::stod(it->second);
+    }
+
+    /* comma-separated lists: key=a,b,c */
+    std::vector<std::string> getList(const std::string &key,const std::string &def) const {
+        std::vector<std::string> v;
+        std::stringstream ss(getString(key,def));
+        std::string item;
+        while(std::getline(ss,item,',')){
+            if(!item.empty()) v.push_back(item);
+        }
+        return v;
+    }
+
+    std::vector<int> getIntList(const std::string &key,const std::string &def) const {
+        std::vector<int> v;
+        for(const std::string &item : getList(key,def)) v.push_back(std::stoi(item));
+        return v;
+    }
+
+    void set(const std::string &key,const std::string &value){
+        values[key] = value;
+    }
+
+  private:
+    std::map<std::string,std::string> values;
+};
+
+#endif /* OPTIONS_HXX */
@@ -0,0 +1,84 @@
+/**
+ * File:   Partition.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef PARTITION_HXX
+#define PARTITION_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+
+/**
+ * Line-preserving domain decomposition: every rank reads the full mesh,
+ * keeps a contiguous range of whole lines (balanced by element count)
+ * and renumbers its Mesh/Jacobian to local ids:
+ *   [0,nown)             owned elements, line elements in line order
+ *   [nown,nown+nghost)   ghost elements, grouped by owning rank
+ * Ghost U values arrive by a halo exchange; since ghosts of one rank are
+ * contiguous, each receive is copied straight into o_U. The residual is
+ * split into interior elements (no ghost neighbor), computed while the
+ * exchange is in flight, and boundary elements, computed after it.
+ */
+class Partition {
+  public:
+    Platform &gpu;
+
+    int nown;           /**< owned elements */
+    int nghost;         /**< ghost elements */
+    int nelem_global;
+    int nline_global;
+
+    std::vector<int> owner;     /**< [nelem_global] owning rank */
+    std::vector<int> localelem; /**< [nown+nghost] local -> global element */
+    std::vector<int> localface; /**< local -> global face */
+
+    /* halo: per neighbor n, sendlist[sendpoint[n]:sendpoint[n+1]] goes out
+     * and ghosts [nown+recvpoint[n], nown+recvpoint[n+1]) come in; both
+     * sides order the elements by global id */
+    std::vector<int> nbr;
+    std::vector<int> sendpoint;
+    std::vector<int> sendlist;
+    std::vector<int> recvpoint;
+
+    /* residual phases: owned line elements without/with ghost neighbors */
+    std::vector<int> interior;
+    std::vector<int> boundary;
+
+    occa::kernel haloPack;
+    occa::memory o_sendlist;
+    occa::memory o_sendbuf;
+    occa::memory o_interior;
+    occa::memory o_boundary;
+    occa::memory h_sendmem;
+    occa::memory h_recvmem;
+
+    /* constructors */
+    Partition(Platform &_gpu):
+        gpu(_gpu),nown(0),nghost(0),nelem_global(0),nline_global(0),
+        nvar(0),h_send(nullptr),h_recv(nullptr)
+    {}
+   ~Partition(){};
+
+    /* methods */
+    void decompose(Mesh &mesh,Jacobian &Jac);
+    void setupDevice(const occa::properties &kernelProps);
+    void exchangeStart(occa::memory &o_U);
+    void exchangeFinish(occa::memory &o_U);
+    void printStats() const;
+
+  private:
+    int nvar;
+    double *h_send;
+    double *h_recv;
+    occa::streamTag sendTag;
+    occa::streamTag recvTag;
+    std::vector<MPI_Request> requests;
+};
+
+#endif /* PARTITION_HXX */
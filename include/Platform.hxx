@@ -10,6 +10,7 @@
 
 /*header files */
 #include "core.hxx"
+#include "Profiler.hxx"
 
 /* system header files */
 #include <unistd.h>
@@ -21,6 +22,7 @@
 #define OPENMP_MODE 4
 #define DPCPP_MODE  5
 #define METAL_MODE  6
+#define NATIVE_MODE 7 /* host C++ line engine on OCCA Serial memory */
 
 class Platform {
   public:
@@ -30,14 +32,21 @@ class Platform {
     occa::device device;
 
     int rank, nrank;
+    int mode;
+    int warm;                /**< 1: kernel binaries cached (KernelCache), no build barriers */
+    std::string deviceSetup; /**< occa::device setup string */
+    Profiler prof;           /**< launch instrumentation (profile=1) */
 
     /* constructors */
     Platform(MPI_Comm _comm,int thread_model,int device_id=0,int platform=0):
-        comm(_comm)
+        comm(_comm),mode(thread_model),warm(0)
     {
         MPI_Comm_rank(_comm, &rank);
         MPI_Comm_size(_comm, &nrank);
         DeviceConfig(thread_model,device_id,platform);
+        prof.attach(device,comm,thread_model == SERIAL_MODE
+                              ||thread_model == OPENMP_MODE
+                              ||thread_model == NATIVE_MODE);
     }
 
    ~Platform(){}
@@ -48,6 +57,9 @@ class Platform {
                              const occa::json  &props = occa::json()){
         occa::kernel kernel;
 
+        /* warm cache: every rank loads the binary, nothing to serialize */
+        if(warm) return device.buildKernel(fileName,kernelName,props);
+
         /* build on root first */
         if(!rank) kernel = device.buildKernel(fileName,kernelName,props);
         MPI_Barrier(comm);
@@ -0,0 +1,117 @@
+/**
+ * File:   Profiler.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef PROFILER_HXX
+#define PROFILER_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Options.hxx"
+
+/* system header files */
+#include <map>
+
+/* trace lanes */
+#define PROFILE_COMPUTE  0 /**< compute stream (device tags) */
+#define PROFILE_TRANSFER 1 /**< transfer stream (device tags) */
+#define PROFILE_HOST     2 /**< host wall time (MPI waits) */
+#define PROFILE_LANES    3
+
+#define PROFILE_MAX_DEPTH 8
+#define PROFILE_COUNTERS  4 /**< cycles, instructions, cache references, cache misses */
+
+/**
+ * Launch instrumentation (profile=1), owned by Platform. Named scopes
+ * around kernel launches record device time from stream tags, the
+ * call count and the bytes of the solver's model for that phase; on
+ * CPU modes they also read hardware counters (perf_event_open), one set
+ * per OpenMP thread summed over the pool. Tags
+ * are resolved in batches, so profiling adds no synchronization inside
+ * a sweep. finish() prints a per-name summary with the spread over
+ * ranks and writes every scope as a Chrome trace (chrome://tracing,
+ * Perfetto), one process per rank. Disabled scopes cost one branch.
+ */
+class Profiler {
+  public:
+    int enabled;
+    int bins;               /**< 1: time each line-length bin separately */
+    int counters;           /**< 1: hardware counters open */
+    std::string file;       /**< Chrome trace file ("": none) */
+
+    /* constructors */
+    Profiler();
+   ~Profiler();
+
+    /* methods */
+    void attach(occa::device &_device,MPI_Comm _comm,int cpu);
+    void enable(const Options &opts);
+    int begin(const char *name,double bytes,int lane);
+    void end(int id);
+    void finish();
+
+  private:
+    struct Event {
+        std::string name;
+        int lane,depth;
+        double host,hostEnd;    /**< host wall time at begin/end */
+        double bytes;
+        occa::streamTag start,stop;
+        long long count[PROFILE_COUNTERS];
+    };
+    struct Stat {
+        long long calls;
+        double total,min,max,bytes;
+        long long count[PROFILE_COUNTERS];
+    };
+
+    occa::device device;
+    MPI_Comm comm;
+    int rank;
+    int cpu;                /**< kernels run on the host: counters apply */
+    std::vector<int> fd;    /**< [thread][counter] perf event descriptors */
+    double t0;
+
+    std::vector<Event> pending;     /**< unresolved scopes, begin order */
+    std::map<std::string,Stat> stats;
+    std::string trace;              /**< resolved Chrome trace events */
+    size_t ntrace,maxTrace;
+    int depth[PROFILE_LANES];
+    double cursor[PROFILE_LANES][PROFILE_MAX_DEPTH+1];
+
+    void flush();
+    void readCounters(long long *v) const;
+    void openCounters();
+    void closeCounters();
+    void report();
+    void writeTrace();
+};
+
+/**
+ * RAII scope: PROFILE_SCOPE(gpu.prof,"solve",solveBytes()) times the
+ * rest of the enclosing block; bytes are only evaluated when enabled.
+ * A null name skips the scope (e.g. per-bin scopes without profile_bins).
+ */
+class ProfileScope {
+  public:
+    ProfileScope(Profiler &_prof,const char *name,double bytes,int lane = PROFILE_COMPUTE):
+        prof(_prof),id(-1)
+    {
+        if(prof.enabled && name) id = prof.begin(name,bytes,lane);
+    }
+   ~ProfileScope(){if(id >= 0) prof.end(id);}
+
+  private:
+    Profiler &prof;
+    int id;
+};
+
+#define PROFILE_SCOPE(prof,name,bytes) \
+    ProfileScope profileScope_(prof,name,(prof).enabled ? (double) (bytes):0.0)
+#define PROFILE_LANE(prof,name,bytes,lane) \
+    ProfileScope profileScope_(prof,name,(prof).enabled ? (double) (bytes):0.0,lane)
+
+#endif /* PROFILER_HXX */
@@ -0,0 +1,79 @@
+/**
+ * File:   Reference.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef REFERENCE_HXX
+#define REFERENCE_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "LineSolver.hxx"
+#include "Options.hxx"
+
+/* largest block size of the reference */
+#define REF_MAX_NVAR 64
+
+/* compared vectors */
+#define REF_DU  0
+#define REF_U   1
+#define REF_RES 2
+
+/**
+ * Correctness oracle: a plain host port of the original OpenMP line
+ * smoother (src/F90/linesmoothLU.f90) with the same loop order: block
+ * Thomas solve per line, U += dU, and the linear residual rebuilt from
+ * the line-factored diagonals. verify() runs a configured LineSolver in
+ * lockstep and compares dU, U and res after every sweep on the line
+ * elements (a solver on a line-ordered copy of the mesh is mapped back
+ * with Mesh::toNative). The error is max|x - x_ref| over max|U_ref| (dU, U) or
+ * max|rhs| (res): dU and res go to zero as the sweeps converge, their
+ * rounding does not. Sweep k passes when every error is <= k*tol, since
+ * factor rounding adds up over the sweeps. tol comes from the factor
+ * storage precision (verify_tol=X overrides it).
+ */
+class Reference {
+  public:
+    double tol;
+    std::vector<double> err[3];     /**< [iters] error of dU, U, res per sweep */
+    int failIter;                   /**< first failing sweep (0: passed) */
+
+    std::vector<double> Dia;        /**< line-factored diagonal blocks */
+    std::vector<double> dU,U,R;
+
+    /* constructors */
+    Reference(const Mesh &_mesh,const Jacobian &_Jac);
+   ~Reference(){};
+
+    /* methods */
+    void factor();
+    void reset(const double *U0);
+    void sweep();
+    bool verify(LineSolver &solver,const std::vector<double> &U0,int iters);
+    void printHistory() const;
+    double maxError(int v) const;
+
+    static double tolerance(const Options &opts);
+
+  private:
+    const Mesh &mesh;
+    const Jacobian &Jac;
+    int nvar;
+
+    void solveLine(int l);
+    void residualLine(int l);
+    double error(const std::vector<double> &x,const std::vector<double> &xref) const;
+    double maxAbs(const double *x) const;
+    const double *offBlock(int e,int f) const;
+
+    static void LU(double *M,int n);
+    static void solveLU(const double *M,const double *b,double *x,int n);
+    static void LUmatmul(const double *M,const double *x,double *y,int n);
+    static void matmul(const double *M,const double *x,double *y,int n);
+};
+
+#endif /* REFERENCE_HXX */
@@ -0,0 +1,117 @@
+/**
+ * File:   Transfer.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef TRANSFER_HXX
+#define TRANSFER_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "MappedFile.hxx"
+
+/* pinned staging buffers in the ring */
+#define TRANSFER_SLOTS 4
+
+/**
+ * Host-device transfers on a dedicated stream. Host data is staged in a
+ * ring of pinned buffers (Platform::hostMalloc) and copied chunk by chunk
+ * with async copies, so the host fills the next slot while the previous
+ * chunks are in flight and kernels on the compute stream keep running.
+ * Small arrays share a slot; a slot is reused once its last copy is done.
+ * Uploads may return before the data has arrived: wait on a tag() taken
+ * after them before a kernel reads the memory. Downloads land in the
+ * staging ring and are copied to their destination when the slot is
+ * reused or at finish(); the destination is only valid after finish().
+ */
+class Transfer {
+  public:
+    Platform &gpu;
+    occa::stream stream;
+    size_t slotBytes;
+
+    /* constructors */
+    Transfer(Platform &_gpu,size_t _slotBytes = MAPPED_CHUNK_BYTES);
+   ~Transfer(){finish();};
+
+    Transfer(const Transfer&) = delete;
+    Transfer& operator=(const Transfer&) = delete;
+
+    /* methods */
+    occa::streamTag tag();
+    void wait(const occa::streamTag &t);
+    void finish();
+
+    /* host -> device: count entries into o_mem at entry offset; mapped
+     * file pages are prefetched one chunk ahead (see uploadChunked) */
+    template <class T>
+    void upload(occa::memory &o_mem,const T *src,size_t count,size_t offset = 0,
+                const MappedFile *file = nullptr){
+        const size_t chunk = slotBytes/sizeof(T);
+
+        if(file) file->prefetch(src,std::min(chunk,count)*sizeof(T));
+        for(size_t n0 = 0; n0 < count; n0 += chunk){
+            const size_t n = std::min(chunk,count-n0);
+            const size_t next = n0 + n;
+
+            char *buf = acquire(n*sizeof(T));
+            memcpy(buf,src+n0,n*sizeof(T));
+            if(file && next < count){
+                file->prefetch(src+next,std::min(chunk,count-next)*sizeof(T));
+            }
+            copy(buf,o_mem,n,offset+n0,n*sizeof(T),true);
+        }
+    }
+
+    template <class T>
+    void upload(occa::memory &o_mem,const HostArray<T> &h,const MappedFile &file){
+        upload(o_mem,h.data(),h.size(),0,h.isView() ? &file:nullptr);
+    }
+
+    template <class T>
+    void upload(occa::memory &o_mem,const std::vector<T> &h){
+        upload(o_mem,h.data(),h.size());
+    }
+
+    /* device -> host: count entries of o_mem at entry offset into dst */
+    template <class T>
+    void download(T *dst,occa::memory &o_mem,size_t count,size_t offset = 0){
+        const size_t chunk = slotBytes/sizeof(T);
+
+        for(size_t n0 = 0; n0 < count; n0 += chunk){
+            const size_t n = std::min(chunk,count-n0);
+
+            char *buf = acquire(n*sizeof(T));
+            copy(buf,o_mem,n,offset+n0,n*sizeof(T),false);
+            landing[cur].push_back({reinterpret_cast<char*>(dst+n0),buf,n*sizeof(T)});
+        }
+    }
+
+    /* split n items into nparts contiguous parts: first item of part p */
+    static size_t split(size_t n,int p,int nparts){
+        return (n*p)/nparts;
+    }
+
+  private:
+    struct Landing {
+        char *dst;
+        const char *src;
+        size_t bytes;
+    };
+
+    int cur;                                 /**< slot being filled */
+    occa::memory h_slot[TRANSFER_SLOTS];
+    char *slot[TRANSFER_SLOTS];
+    size_t used[TRANSFER_SLOTS];             /**< bytes queued in the slot */
+    occa::streamTag slotTag[TRANSFER_SLOTS]; /**< last copy queued from the slot */
+    std::vector<Landing> landing[TRANSFER_SLOTS];
+
+    char *acquire(size_t bytes);
+    void release(int s);
+    void copy(char *buf,occa::memory &o_mem,size_t count,size_t offset,size_t bytes,bool toDevice);
+};
+
+#endif /* TRANSFER_HXX */
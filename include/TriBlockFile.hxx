@@ -0,0 +1,121 @@
+/**
+ * File:   TriBlockFile.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef TRIBLOCKFILE_HXX
+#define TRIBLOCKFILE_HXX
+
+/* header files */
+#include "core.hxx"
+#include "MappedFile.hxx"
+
+/* system header files */
+#include <cstdint>
+
+/* ================================================================== *
+ * Versioned on-disk format (gpuline.data.tbk)                        *
+ * ------------------------------------------------------------------ *
+ *  [header: 384 bytes][section 0][pad]...[section N-1][pad]          *
+ *                                                                    *
+ *  - every section starts on a 64-byte boundary                      *
+ *  - all indices are 0-based (no rebasing on load)                   *
+ *  - each section carries a checksum (see TriBlockFile::checksum)    *
+ *  - optional sections: packed tri-block A, line-ordered numbering   *
+ * ================================================================== */
+#define TRIBLOCK_FILE_NAME    "gpuline.data.tbk"
+#define TRIBLOCK_FILE_MAGIC   "TRIBLOCK"
+#define TRIBLOCK_FILE_VERSION 1
+#define TRIBLOCK_FILE_ALIGN   64
+
+/* header flags */
+#define TRIBLOCK_FLAG_PACKED_A   1  /**< SEC_A holds assembleTriBlocks output */
+#define TRIBLOCK_FLAG_LINE_ORDER 2  /**< elements renumbered so lines[m] == m */
+
+/* section ids */
+enum {
+    SEC_EPOINT = 0, /**< int [nelem+1] */
+    SEC_EF,         /**< int [eftot] */
+    SEC_FC,         /**< int [2*nintface] */
+    SEC_LINESIZE,   /**< int [nline] */
+    SEC_LINEPOINT,  /**< int [nline+1] */
+    SEC_LINES,      /**< int [nlineelem] */
+    SEC_LINEFACE,   /**< int [nlineelem] */
+    SEC_JACD,       /**< double [nvar*nvar*nelem] */
+    SEC_JACO1,      /**< double [nvar*nvar*nintface] */
+    SEC_JACO2,      /**< double [nvar*nvar*nintface] */
+    SEC_RHS,        /**< double [nvar*nelem] */
+    SEC_U0,         /**< double [nvar*nelem] */
+    SEC_A,          /**< double [nvar*nvar*nlineelem] (optional) */
+    SEC_ELEMPERM,   /**< int [nelem]: file element -> original element (optional) */
+    SEC_COUNT
+};
+
+/* section sets (checksums verified by TriBlockFile::read): Mesh and
+ * Jacobian map the same file, each verifies its own sections only */
+#define TRIBLOCK_SECTIONS_MESH ((1u<<SEC_EPOINT) | (1u<<SEC_EF) | (1u<<SEC_FC) | \
+                                (1u<<SEC_LINESIZE) | (1u<<SEC_LINEPOINT) | (1u<<SEC_LINES) | \
+                                (1u<<SEC_LINEFACE) | (1u<<SEC_ELEMPERM))
+#define TRIBLOCK_SECTIONS_JAC  ((1u<<SEC_JACD) | (1u<<SEC_JACO1) | (1u<<SEC_JACO2) | \
+                                (1u<<SEC_RHS) | (1u<<SEC_U0) | (1u<<SEC_A))
+#define TRIBLOCK_SECTIONS_ALL  ((1u<<SEC_COUNT) - 1)
+
+struct TriBlockSection {
+    uint64_t offset;    /**< byte offset from start of file */
+    uint64_t bytes;     /**< section size in bytes (0 if absent) */
+    uint64_t checksum;  /**< TriBlockFile::checksum of the section */
+};
+
+struct TriBlockHeader {
+    char magic[8];
+    int32_t version;
+    int32_t flags;
+    int32_t nvar;
+    int32_t nelem;
+    int32_t nintface;
+    int32_t eftot;
+    int32_t nline;
+    int32_t nlineelem;
+    int32_t max_line_nelem;
+    int32_t reserved;
+    TriBlockSection section[SEC_COUNT];
+};
+static_assert(sizeof(TriBlockHeader) % TRIBLOCK_FILE_ALIGN == 0,
+              "TriBlockHeader must preserve section alignment");
+
+class TriBlockFile {
+  public:
+    TriBlockHeader header;
+
+    /* constructors */
+    TriBlockFile(){};
+   ~TriBlockFile(){};
+
+    /* methods */
+    static bool isTriBlock(const MappedFile &file);
+    static uint64_t checksum(const void *data,size_t bytes);
+
+    bool read(const MappedFile &file,uint32_t verify = TRIBLOCK_SECTIONS_ALL);
+    bool has(int id) const {return header.section[id].bytes > 0;}
+    size_t count(int id,size_t size) const {return header.section[id].bytes/size;}
+
+    template <class T>
+    T *section(const MappedFile &file,int id) const {
+        return file.ptr<T>(header.section[id].offset);
+    }
+
+    template <class T>
+    void wrap(HostArray<T> &h,const MappedFile &file,int id) const {
+        h.wrap(section<T>(file,id),count(id,sizeof(T)));
+    }
+
+    /* writer: arrays are given in section order; absent sections are {nullptr,0} */
+    static bool write(const std::string &fileName,
+                      TriBlockHeader &hdr,
+                      const void *data[SEC_COUNT],
+                      const size_t bytes[SEC_COUNT]);
+};
+
+#endif /* TRIBLOCKFILE_HXX */
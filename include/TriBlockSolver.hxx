@@ -0,0 +1,77 @@
+/**
+ * File:   TriBlockSolver.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef TRIBLOCKSOLVER_HXX
+#define TRIBLOCKSOLVER_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Platform.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "Transfer.hxx"
+#include "LineSolver.hxx"
+#include "Options.hxx"
+#include "triblock.h"
+
+/**
+ * Embeddable line-Jacobi solver (C API: triblock.h). Wraps Platform,
+ * Mesh, Jacobian and LineSolver for a flow solver that hands over its
+ * line system in memory instead of through gpuline.*.data.bin files.
+ * Host arrays are viewed in place and staged through pinned memory;
+ * device arrays (raw pointers of the platform's mode or occa::memory)
+ * are used in place with the low-memory kernels. Each rank owns an
+ * independent system (MPI_COMM_SELF). Methods print the error and return
+ * TRIBLOCK_ERROR instead of exiting the host process.
+ */
+class TriBlockSolver {
+  public:
+    Options opts;
+    Platform gpu;
+    Mesh mesh;
+    Jacobian Jac;
+    Transfer xfer;
+    LineSolver *solver;
+
+    int location;   /**< TRIBLOCK_HOST/TRIBLOCK_DEVICE Jacobian, -1: not set */
+    int hasMesh;
+    int staged;     /**< 1: host blocks not yet uploaded (factor streams them) */
+    int factored;
+
+    /* last solve */
+    int niter;
+    double resNorm;
+    int status;     /**< Convergence status */
+
+    /* constructors */
+    TriBlockSolver(int mode,int device_id,const Options &_opts);
+   ~TriBlockSolver(){delete solver;};
+
+    /* methods: TRIBLOCK_SUCCESS or TRIBLOCK_ERROR */
+    int setMesh(int nelem,int nintface,int eftot,
+                const int *epoint,const int *ef,const int *fc,
+                int nline,int nlineelem,const int *linesize,const int *linepoint,
+                const int *lines,const int *lineface,int base);
+    int setJacobian(int nvar,const double *D,const double *O1,const double *O2,
+                    const double *rhs,int where);
+    int setJacobian(int nvar,occa::memory &o_D,occa::memory &o_O1,occa::memory &o_O2,
+                    occa::memory &o_rhs);
+    int setRhs(int nrhs,const double *B);
+    int factor();
+    int solve(double *U,int where);
+    int solve(occa::memory &o_U);
+
+    /* raw device pointer of this platform's mode -> occa::memory */
+    occa::memory wrap(const double *ptr,size_t count);
+
+  private:
+    int prepare(int nvar);
+    int build();
+    void iterate();
+};
+
+#endif /* TRIBLOCKSOLVER_HXX */
@@ -0,0 +1,37 @@
+/**
+ * File:   Variants.hxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef VARIANTS_HXX
+#define VARIANTS_HXX
+
+/* header files */
+#include "core.hxx"
+#include "Options.hxx"
+
+/**
+ * Named kernel variants shared by the benchmark and verification
+ * drivers. A variant is a set of solver options ("unroll=0,schedule=1")
+ * applied on top of the command line. variant.<name>=k=v,... defines a
+ * new one or replaces a built-in one.
+ */
+class Variants {
+  public:
+    static int count();
+    static const char *name(int v);
+    static const char *settings(int v);
+
+    /* names from key=a,b,... ("all": every built-in variant) */
+    static std::vector<std::string> list(const Options &opts,const std::string &key,const std::string &def);
+
+    /* settings of a variant, false if unknown */
+    static bool lookup(const Options &opts,const std::string &name,std::string &settings);
+
+    /* command line options with the variant settings applied */
+    static Options merge(const Options &opts,const std::string &settings);
+};
+
+#endif /* VARIANTS_HXX */
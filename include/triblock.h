@@ -0,0 +1,91 @@
+/**
+ * File:   triblock.h
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef TRIBLOCK_H
+#define TRIBLOCK_H
+
+/**
+ * C API of the triblock library: hand a line system to the line-Jacobi
+ * solver in memory (no gpuline.*.data.bin files). Array layouts follow
+ * linesmoothLU.f90: blocks are (nvar,nvar,n) and vectors (nvar,nelem),
+ * column-major; index arrays start at base (1: Fortran, 0: C).
+ *
+ *   triblock_create(&tb,mode,device_id,"iters=20 tol_rel=1e-6");
+ *   triblock_set_mesh(tb,...);
+ *   triblock_set_jacobian(tb,nvar,D,O1,O2,rhs,TRIBLOCK_HOST);
+ *   triblock_set_rhs(tb,nrhs,B);          (optional: batched rhs)
+ *   triblock_factor(tb);
+ *   triblock_solve(tb,U,TRIBLOCK_HOST,&niter,&resnorm);
+ *   triblock_destroy(&tb);
+ *
+ * Host arrays are read in place: the mesh arrays must stay valid until
+ * triblock_destroy (0-based) or triblock_set_mesh returns (1-based), the
+ * Jacobian arrays until triblock_factor returns. Device arrays are raw
+ * pointers of the selected mode (CUDA/HIP device memory, OpenCL cl_mem)
+ * and are used in place until the next triblock_set_jacobian. With the
+ * line_order=W option the host blocks are copied into line order and U
+ * is mapped in triblock_solve (device arrays are rejected).
+ *
+ * Every call returns TRIBLOCK_SUCCESS or TRIBLOCK_ERROR (message on
+ * stdout), e.g. a second triblock_set_mesh, a block size different from
+ * the first triblock_set_jacobian, triblock_factor before a Jacobian, or
+ * an unsupported option combination.
+ */
+
+/* location of caller arrays */
+#define TRIBLOCK_HOST   0
+#define TRIBLOCK_DEVICE 1
+
+/* return codes */
+#define TRIBLOCK_SUCCESS 0
+#define TRIBLOCK_ERROR   1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct triblock_s *triblock_t;
+
+/* mode: compute mode as in triblock.exe (0=Serial, 1=HIP, 2=CUDA, ...);
+ * options: "key=value ..." as on the triblock.exe command line (may be NULL) */
+int triblock_create(triblock_t *tb,int mode,int device_id,const char *options);
+
+int triblock_set_mesh(triblock_t tb,int nelem,int nintface,int eftot,
+                      const int *epoint,const int *ef,const int *fc,
+                      int nline,int nlineelem,const int *linesize,const int *linepoint,
+                      const int *lines,const int *lineface,int base);
+
+/* D(nvar,nvar,nelem), O1/O2(nvar,nvar,nintface), rhs(nvar,nelem) */
+int triblock_set_jacobian(triblock_t tb,int nvar,const double *D,const double *O1,
+                          const double *O2,const double *rhs,int location);
+
+/* nrhs right-hand sides rhs(nvar,nrhs,nelem) for the current host
+ * Jacobian (copied), solved together with each block reused across
+ * them; triblock_solve then takes U(nvar,nrhs,nelem). May follow
+ * triblock_factor: the factors are kept, only the sweep kernels are
+ * rebuilt. The next triblock_set_jacobian goes back to its single rhs */
+int triblock_set_rhs(triblock_t tb,int nrhs,const double *rhs);
+
+int triblock_factor(triblock_t tb);
+
+/* U(nvar,nelem): initial guess in, solution out; niter/resnorm may be NULL.
+ * Returns TRIBLOCK_ERROR if the iteration diverged */
+int triblock_solve(triblock_t tb,double *U,int location,int *niter,double *resnorm);
+
+int triblock_destroy(triblock_t *tb);
+
+#ifdef __cplusplus
+}
+
+/* C++ callers: existing occa::memory buffers, used in place */
+#include <occa.hpp>
+int triblock_set_jacobian_occa(triblock_t tb,int nvar,occa::memory &o_D,occa::memory &o_O1,
+                               occa::memory &o_O2,occa::memory &o_rhs);
+int triblock_solve_occa(triblock_t tb,occa::memory &o_U,int *niter,double *resnorm);
+#endif
+
+#endif /* TRIBLOCK_H */
@@ -0,0 +1,220 @@
+/**
+ * \file    Autotuner.cxx
+ * \author  akirby
+ *
+ * \brief Autotuner class implementation
+ */
+
+/* header files */
+#include "Autotuner.hxx"
+#include "LineSolver.hxx"
+#include "Variants.hxx"
+
+/* system header files */
+#include <fstream>
+#include <cstdio>
+
+/* options chosen by the tuner */
+static const char *tuned_keys[] = {"unroll","lines_per_block","schedule","cr_min","vec_block"};
+
+/* accepted dU difference to the reference kernels (relative to max|dU|) */
+#define TUNE_TOL 1.0e-8
+
+Autotuner::Autotuner(Platform &_gpu,Mesh &_mesh,Jacobian &_Jac,const Options &opts):
+    gpu(_gpu),mesh(_mesh),Jac(_Jac)
+{
+    reps  = opts.getInt("tune_reps",10);
+    force = (opts.getInt("tune",0) > 1);
+
+    /* database: next to the OCCA cache directory */
+    std::string cache = occa::env::OCCA_CACHE_DIR;
+    if(cache.empty()){
+        const char *home = getenv("HOME");
+        cache = std::string(home ? home:".") + "/.occa";
+    }
+    while(cache.size() > 1 && cache.back() == '/') cache.pop_back();
+    const size_t slash = cache.rfind('/');
+    const std::string dir = (slash == std::string::npos) ? ".":cache.substr(0,slash);
+    file = opts.getString("tune_file",dir + "/triblock_tuning.db");
+
+    /* mesh signature: sizes + FNV-1a hash of the line lengths */
+    unsigned long long h = 1469598103934665603ULL;
+    for(int l = 0; l < mesh.nline; ++l){
+        h = (h ^ (unsigned long long) mesh.linesize[l])*1099511628211ULL;
+    }
+    char hash[32];
+    snprintf(hash,sizeof(hash),"%016llx",h);
+
+    char host[MPI_MAX_PROCESSOR_NAME];
+    int len;
+    MPI_Get_processor_name(host,&len);
+
+    const std::string arch = gpu.device.arch();
+    key = "mode=" + gpu.device.mode()
+        + (arch.empty() ? "":";arch=" + arch)
+        + ";host=" + std::string(host)
+        + ";nvar=" + std::to_string(Jac.nvar)
+        + ";nelem=" + std::to_string(mesh.nelem)
+        + ";nline=" + std::to_string(mesh.nline)
+        + ";maxlen=" + std::to_string(mesh.max_line_nelem)
+        + ";lines=" + hash;
+}
+
+void Autotuner::apply(Options &opts){
+    /* the tuner only chooses among default-path variants */
+    if(gpu.nrank > 1 || gpu.mode == NATIVE_MODE || Jac.lowmem || Jac.nrhs > 1 ||
+       opts.getInt("fused",0) || opts.getInt("line_order",0) || opts.getInt("adjoint",0) ||
+       opts.getString("precision","fp64") != "fp64"){
+        printf("\x1B[1;31mERROR: tune=1 requires a single rank, a device mode, fp64 and fused/lowmem/nrhs/line_order/adjoint off\x1B[0m\n");
+        exit(1);
+    }
+    for(const char *k : tuned_keys){
+        if(opts.has(k)){
+            printf("\x1B[1;31mERROR: tune=1 chooses %s; do not set it\x1B[0m\n",k);
+            exit(1);
+        }
+    }
+
+    std::string settings;
+    if(!force && lookup(settings)){
+        printf("tuning: %s (database %s)\n",settings.c_str(),file.c_str());
+        opts = Variants::merge(opts,settings);
+        return;
+    }
+
+    printf("tuning: %s\n",key.c_str());
+
+    /* trials overwrite U, dU and the factors: keep U */
+    std::vector<double> U0(Jac.U.size());
+    Jac.o_U.copyTo(U0.data());
+
+    /* 1.) line kernel variants, checked against the reference (first) */
+    std::vector<double> ref(Jac.dU.size());
+    std::vector<double> dU(Jac.dU.size());
+    std::string best;
+    double best_time = 0.0;
+
+    const std::vector<std::string> candidates = variants();
+    for(size_t v = 0; v < candidates.size(); ++v){
+        const std::string trialset = candidates[v] + ",vec_block=256";
+        Jac.o_U.copyFrom(U0.data());
+        const double time = trial(Variants::merge(opts,trialset),v ? dU:ref);
+
+        double err = 0.0;
+        double scale = 0.0;
+        for(size_t n = 0; v && n < dU.size(); ++n){
+            err = std::max(err,std::fabs(dU[n]-ref[n]));
+            scale = std::max(scale,std::fabs(ref[n]));
+        }
+        const bool valid = (err <= TUNE_TOL*scale);
+
+        printf("  %-64s %12.6f s %s\n",trialset.c_str(),time,valid ? "":"(rejected: dU mismatch)");
+        if(valid && (best.empty() || time < best_time)){
+            best = candidates[v];
+            best_time = time;
+        }
+    }
+
+    /* 2.) vector kernel launch size for the winner */
+    std::string winner = best + ",vec_block=256";
+    for(int vb : {128,512,1024}){
+        const std::string trialset = best + ",vec_block=" + std::to_string(vb);
+        Jac.o_U.copyFrom(U0.data());
+        const double time = trial(Variants::merge(opts,trialset),dU);
+
+        printf("  %-64s %12.6f s\n",trialset.c_str(),time);
+        if(time < best_time){
+            winner = trialset;
+            best_time = time;
+        }
+    }
+    Jac.o_U.copyFrom(U0.data());
+
+    printf("tuning: %s (%f s, stored in %s)\n",winner.c_str(),best_time,file.c_str());
+    store(winner,best_time);
+    opts = Variants::merge(opts,winner);
+}
+
+std::vector<std::string> Autotuner::variants() const {
+    const int nvar = Jac.nvar;
+    std::vector<std::string> v;
+
+    /* reference first */
+    v.push_back("unroll=0,lines_per_block=0,schedule=0,cr_min=0");
+    v.push_back("unroll=1,lines_per_block=0,schedule=0,cr_min=0");
+
+    /* batched lines: NVAR^2 threads per line */
+    for(int n = 1; n*nvar*nvar <= 1024; n *= 2){
+        v.push_back("unroll=0,lines_per_block=" + std::to_string(n) + ",schedule=0,cr_min=0");
+    }
+    v.push_back("unroll=0,lines_per_block=0,schedule=1,cr_min=0");
+
+    /* cyclic reduction only pays off for long lines */
+    if(mesh.max_line_nelem >= 64){
+        v.push_back("unroll=0,lines_per_block=0,schedule=0,cr_min=64");
+    }
+    return v;
+}
+
+double Autotuner::trial(const Options &opts,std::vector<double> &dU){
+    LineSolver solver(gpu,mesh,Jac,opts);
+    solver.setup();
+    gpu.device.finish();
+
+    /* factor + first solve (checked against the reference) */
+    occa::streamTag start = gpu.device.tagStream();
+        solver.factor();
+        solver.reset();
+        solver.solve();
+    occa::streamTag end = gpu.device.tagStream();
+    gpu.device.finish();
+    double time = gpu.device.timeBetween(start,end);
+    Jac.o_dU.copyTo(dU.data());
+
+    /* timed sweeps */
+    start = gpu.device.tagStream();
+    for(int r = 0; r < reps; ++r){
+        solver.update();
+        solver.residual();
+        solver.solve();
+    }
+    end = gpu.device.tagStream();
+    gpu.device.finish();
+    time += gpu.device.timeBetween(start,end);
+
+    return time;
+}
+
+bool Autotuner::lookup(std::string &settings) const {
+    std::ifstream in(file);
+    std::string k,s;
+    double time;
+    while(in >> k >> s >> time){
+        if(k == key){
+            settings = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Autotuner::store(const std::string &settings,double time) const {
+    /* keep the other keys, replace ours */
+    std::vector<std::string> lines;
+    std::ifstream in(file);
+    std::string line;
+    while(std::getline(in,line)){
+        if(line.compare(0,key.size()+1,key + " ") != 0) lines.push_back(line);
+    }
+    in.close();
+
+    const std::string tmp = file + ".tmp";
+    std::ofstream out(tmp);
+    for(auto &l : lines) out << l << "\n";
+    out << key << " " << settings << " " << time << "\n";
+    out.close();
+
+    if(!out || rename(tmp.c_str(),file.c_str())){
+        printf(YELLOW "WARNING: could not write tuning database %s" COLOR_OFF "\n",file.c_str());
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * \file    BlockCodegen.cxx
+ * \author  akirby
+ *
+ * \brief BlockCodegen: unrolled block operations emitted into kernelProps
+ */
+
+/* header files */
+#include "BlockCodegen.hxx"
+
+/* block sizes with unrolled kernels */
+static const int specialized_nvar[] = {5,7,9,13};
+
+bool BlockCodegen::specialized(int nvar){
+    for(int n : specialized_nvar){
+        if(n == nvar) return true;
+    }
+    return false;
+}
+
+std::vector<std::pair<std::string,std::string>> BlockCodegen::macros(int nvar){
+    std::vector<std::pair<std::string,std::string>> m;
+    if(!specialized(nvar)) return m;
+
+    m.push_back({"blockLU(A)",LU(nvar)});
+    m.push_back({"blockSolveLU(A,b,x)",solveLU(nvar)});
+    m.push_back({"blockRowDot(M,i,x)",rowDot(nvar)});
+    return m;
+}
+
+void BlockCodegen::define(occa::properties &props,int nvar){
+    if(!specialized(nvar)) return;
+
+    props["defines/p_Unrolled"] = 1;
+    for(auto &macro : macros(nvar)){
+        props["defines/" + macro.first] = macro.second;
+    }
+}
+
+/* register name of block entry (i,j) */
+static std::string reg(int nvar,int i,int j){
+    return "a" + std::to_string(i + nvar*j);
+}
+
+/* literal offset of block entry (i,j) */
+static std::string at(const char *M,int nvar,int i,int j){
+    return std::string("(") + M + ")[" + std::to_string(i + nvar*j) + "]";
+}
+
+std::string BlockCodegen::LU(int nvar){
+    std::ostringstream s;
+
+    /* load the block into registers */
+    s << "{";
+    for(int j = 0; j < nvar; ++j){
+        for(int i = 0; i < nvar; ++i){
+            s << "double " << reg(nvar,i,j) << " = " << at("A",nvar,i,j) << "; ";
+        }
+    }
+
+    /* right-looking elimination, same order as the loop version */
+    for(int j = 0; j < nvar; ++j){
+        s << "const double p" << j << " = 1.0/" << reg(nvar,j,j) << "; ";
+        for(int i = j+1; i < nvar; ++i){
+            s << reg(nvar,i,j) << " *= p" << j << "; ";
+            for(int k = j+1; k < nvar; ++k){
+                s << reg(nvar,i,k) << " -= " << reg(nvar,i,j) << "*" << reg(nvar,j,k) << "; ";
+            }
+        }
+    }
+
+    /* store */
+    for(int j = 0; j < nvar; ++j){
+        for(int i = 0; i < nvar; ++i){
+            s << at("A",nvar,i,j) << " = " << reg(nvar,i,j) << "; ";
+        }
+    }
+    s << "}";
+    return s.str();
+}
+
+std::string BlockCodegen::solveLU(int nvar){
+    std::ostringstream s;
+    s << "{";
+
+    /* forward substitution: y = L^(-1)*b */
+    for(int i = 0; i < nvar; ++i){
+        s << "const double y" << i << " = (b)[" << i << "] - (0.0";
+        for(int j = 0; j < i; ++j){
+            s << " + " << at("A",nvar,i,j) << "*y" << j;
+        }
+        s << "); ";
+    }
+
+    /* back substitution: x = U^(-1)*y */
+    for(int i = nvar-1; i >= 0; --i){
+        s << "const double z" << i << " = (y" << i << " - (0.0";
+        for(int j = i+1; j < nvar; ++j){
+            s << " + " << at("A",nvar,i,j) << "*z" << j;
+        }
+        s << "))/" << at("A",nvar,i,i) << "; ";
+    }
+    for(int i = 0; i < nvar; ++i){
+        s << "(x)[" << i << "] = z" << i << "; ";
+    }
+    s << "}";
+    return s.str();
+}
+
+std::string BlockCodegen::rowDot(int nvar){
+    std::ostringstream s;
+    s << "(0.0";
+    for(int j = 0; j < nvar; ++j){
+        s << " + (M)[(i) + " << nvar*j << "]*(x)[" << j << "]";
+    }
+    s << ")";
+    return s.str();
+}
@@ -0,0 +1,103 @@
+/**
+ * \file    Convergence.cxx
+ * \author  akirby
+ *
+ * \brief Convergence class implementation
+ */
+
+/* header files */
+#include "Convergence.hxx"
+
+/* system header files */
+#include <cmath>
+
+const char *Convergence::statusName(int status){
+    return (status == CONV_CONVERGED) ? "converged":
+           (status == CONV_DIVERGED)  ? "diverged":
+           (status == CONV_MAXITER)   ? "max iterations":"running";
+}
+
+void Convergence::setup(size_t nres,int maxIters){
+    N = nres;
+    nblocks = std::max(1,std::min(1024,(int) ((nres + 256 - 1)/256)));
+    maxIter = maxIters;
+    maxChecks = maxIters/checkEvery + 2;
+
+    normPartial = gpu.buildKernel(SOLVER_DIR "/okl/residualNorm_v1.okl","residualNormPartial",occa::properties());
+    normFinal   = gpu.buildKernel(SOLVER_DIR "/okl/residualNorm_v1.okl","residualNormFinal",occa::properties());
+
+    o_partial = gpu.malloc<double>(2*nblocks);
+    o_hist    = gpu.malloc<double>(2*maxChecks);
+
+    /* pinned host copy so the per-check transfer does not block */
+    hist = (double *) gpu.hostMalloc(2*maxChecks*sizeof(double),nullptr,h_hist);
+}
+
+bool Convergence::check(int iter,occa::memory &o_res){
+    if(iter % checkEvery && iter != maxIter) return false;
+
+    const int c = queuedIter.size();
+    if(c >= maxChecks){
+        printf("\x1B[1;31mERROR: more than %d residual checks\x1B[0m\n",maxChecks);
+        exit(1);
+    }
+
+    /* reduce on the device and start the copy back */
+    PROFILE_SCOPE(gpu.prof,"normCheck",N*sizeof(double));
+    normPartial(N,nblocks,o_res,o_partial);
+    normFinal(nblocks,c,o_partial,o_hist);
+    o_hist.copyTo(hist + 2*c,2,2*c,occa::properties("{async: true}"));
+
+    queuedIter.push_back(iter);
+    queuedTag.push_back(gpu.device.tagStream());
+
+    /* decide on the previous check: its copy is one interval behind */
+    if(c > 0) evaluate(c-1);
+    return (status != CONV_RUNNING);
+}
+
+void Convergence::finish(){
+    for(int c = histIter.size(); c < (int) queuedIter.size(); ++c) evaluate(c);
+    if(status == CONV_RUNNING) status = CONV_MAXITER;
+}
+
+void Convergence::evaluate(int c){
+    if(c < (int) histIter.size()) return;
+
+    gpu.device.waitFor(queuedTag[c]);
+
+    double l2 = hist[2*c+0];
+    double linf = hist[2*c+1];
+
+    /* partitioned runs: global norms over all ranks */
+    if(gpu.nrank > 1){
+        double sum = l2*l2;
+        MPI_Allreduce(MPI_IN_PLACE,&sum,1,MPI_DOUBLE,MPI_SUM,gpu.comm);
+        MPI_Allreduce(MPI_IN_PLACE,&linf,1,MPI_DOUBLE,MPI_MAX,gpu.comm);
+        l2 = sqrt(sum);
+    }
+
+    histIter.push_back(queuedIter[c]);
+    histL2.push_back(l2);
+    histLinf.push_back(linf);
+
+    if(status != CONV_RUNNING) return;
+
+    const double r0 = histL2[0];
+    if(std::isnan(l2) || l2 > tolDiv*r0){
+        status = CONV_DIVERGED;
+    } else if(l2 <= tolAbs || l2 <= tolRel*r0){
+        status = CONV_CONVERGED;
+    }
+}
+
+void Convergence::printHistory() const {
+    const double r0 = histL2.empty() ? 1.0:histL2[0];
+
+    printf("  iter        ||r||_2      ||r||_inf   ||r||_2/||r0||_2\n");
+    for(size_t c = 0; c < histIter.size(); ++c){
+        printf("  %4d  %.6e  %.6e  %.6e\n",
+               histIter[c],histL2[c],histLinf[c],(r0 > 0.0) ? histL2[c]/r0:0.0);
+    }
+    printf("  status: %s\n",statusName(status));
+}
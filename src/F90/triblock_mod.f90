@@ -0,0 +1,96 @@
+! =============================================================================
+! File:   triblock_mod.f90
+! Author: akirby
+!
+! Created on October 17, 2026
+!
+! Fortran interface to the triblock library C API (include/triblock.h).
+! Arguments follow linesmoothLU.f90: pass the same arrays with base=1
+! instead of writing gpuline.*.data files. For device arrays, pass them
+! under "!$acc host_data use_device(...)" (or CUDA Fortran device arrays)
+! with location=TRIBLOCK_DEVICE.
+!
+!   call triblock_create_f(tb,2,0,'iters=20 tol_rel=1e-6',ierr)
+!   ierr = triblock_set_mesh(tb,etot,fctot,eftot,epoint,ef,fc, &
+!                            lintot,linelemtot,linsize,linpoint,lines,linface,1)
+!   ierr = triblock_set_jacobian(tb,btot,Dia,Of1,Of2,B,TRIBLOCK_HOST)
+!   ierr = triblock_factor(tb)
+!   U = Ui
+!   ierr = triblock_solve(tb,U,TRIBLOCK_HOST,niter,resnorm)
+!   ierr = triblock_destroy(tb)
+! =============================================================================
+module triblock_mod
+use iso_c_binding
+implicit none
+
+integer(c_int), parameter :: TRIBLOCK_HOST    = 0
+integer(c_int), parameter :: TRIBLOCK_DEVICE  = 1
+integer(c_int), parameter :: TRIBLOCK_SUCCESS = 0
+integer(c_int), parameter :: TRIBLOCK_ERROR   = 1
+
+interface
+   integer(c_int) function triblock_create(tb,mode,device_id,options) bind(C,name='triblock_create')
+      import :: c_int, c_ptr, c_char
+      type(c_ptr), intent(out) :: tb
+      integer(c_int), value :: mode, device_id
+      character(kind=c_char), intent(in) :: options(*)
+   end function triblock_create
+
+   integer(c_int) function triblock_set_mesh(tb,nelem,nintface,eftot,epoint,ef,fc, &
+                                             nline,nlineelem,linesize,linepoint,lines,lineface,base) &
+                                             bind(C,name='triblock_set_mesh')
+      import :: c_int, c_ptr
+      type(c_ptr), value :: tb
+      integer(c_int), value :: nelem, nintface, eftot, nline, nlineelem, base
+      integer(c_int), intent(in) :: epoint(*), ef(*), fc(*)
+      integer(c_int), intent(in) :: linesize(*), linepoint(*), lines(*), lineface(*)
+   end function triblock_set_mesh
+
+   integer(c_int) function triblock_set_jacobian(tb,nvar,D,O1,O2,rhs,location) &
+                                                 bind(C,name='triblock_set_jacobian')
+      import :: c_int, c_ptr, c_double
+      type(c_ptr), value :: tb
+      integer(c_int), value :: nvar, location
+      real(c_double), intent(in) :: D(*), O1(*), O2(*), rhs(*)
+   end function triblock_set_jacobian
+
+   integer(c_int) function triblock_set_rhs(tb,nrhs,rhs) bind(C,name='triblock_set_rhs')
+      import :: c_int, c_ptr, c_double
+      type(c_ptr), value :: tb
+      integer(c_int), value :: nrhs
+      real(c_double), intent(in) :: rhs(*)
+   end function triblock_set_rhs
+
+   integer(c_int) function triblock_factor(tb) bind(C,name='triblock_factor')
+      import :: c_int, c_ptr
+      type(c_ptr), value :: tb
+   end function triblock_factor
+
+   integer(c_int) function triblock_solve(tb,U,location,niter,resnorm) bind(C,name='triblock_solve')
+      import :: c_int, c_ptr, c_double
+      type(c_ptr), value :: tb
+      real(c_double), intent(inout) :: U(*)
+      integer(c_int), value :: location
+      integer(c_int), intent(out) :: niter
+      real(c_double), intent(out) :: resnorm
+   end function triblock_solve
+
+   integer(c_int) function triblock_destroy(tb) bind(C,name='triblock_destroy')
+      import :: c_int, c_ptr
+      type(c_ptr), intent(inout) :: tb
+   end function triblock_destroy
+end interface
+
+contains
+
+! Fortran string options: appends the C terminator
+subroutine triblock_create_f(tb,mode,device_id,options,ierr)
+   type(c_ptr), intent(out) :: tb
+   integer, intent(in) :: mode, device_id
+   character(len=*), intent(in) :: options
+   integer, intent(out) :: ierr
+
+   ierr = triblock_create(tb,int(mode,c_int),int(device_id,c_int),trim(options)//c_null_char)
+end subroutine triblock_create_f
+
+end module triblock_mod
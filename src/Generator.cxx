@@ -0,0 +1,323 @@
+/**
+ * \file    Generator.cxx
+ * \author  akirby
+ *
+ * \brief Generator class implementation
+ */
+
+/* header files */
+#include "Generator.hxx"
+#include "TriBlockFile.hxx"
+
+/* system header files */
+#include <algorithm>
+
+/* random streams */
+enum {GEN_PERM = 1,GEN_LEN,GEN_D,GEN_O1,GEN_O2,GEN_RHS};
+
+/* splitmix64 finalizer */
+static inline unsigned long long mix(unsigned long long x){
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/* boundary face b as stored in ef/lineface (1-based file value -(b+1)) */
+static inline int boundary(int b){
+    return -(b+2);
+}
+
+Generator::Generator(const Options &opts):
+    nvar(0),nelem(0),nintface(0),eftot(0),nline(0),nlineelem(0),max_line_nelem(0)
+{
+    const std::string type = opts.getString("gen","structured");
+    if(type == "structured"){
+        grid = GEN_STRUCTURED;
+    } else if(type == "bl"){
+        grid = GEN_BOUNDARY_LAYER;
+    } else {
+        printf("\x1B[1;31mERROR: unknown gen=%s (structured, bl)\x1B[0m\n",type.c_str());
+        exit(1);
+    }
+
+    ni = opts.getInt("gen_ni",64);
+    nj = opts.getInt("gen_nj",60);
+    if(opts.has("gen_nelem")){
+        const double n = opts.getDouble("gen_nelem",0.0);
+        nj = (int) std::ceil(n/ni);
+    }
+    lineMax   = opts.getInt("gen_line_max",ni);
+    lineMin   = opts.getInt("gen_line_min",lineMax);
+    skew      = opts.getDouble("gen_skew",1.0);
+    dominance = opts.getDouble("gen_dominance",2.0);
+    aniso     = opts.getDouble("gen_aniso",1.0);
+    shuffle   = opts.getInt("gen_shuffle",0);
+    seed      = opts.getInt("gen_seed",1);
+
+    if(ni < 1 || nj < 1 || 4.0*ni*nj > 2147483647.0){
+        printf("\x1B[1;31mERROR: gen_ni=%d x gen_nj=%d is empty or exceeds 32-bit indices\x1B[0m\n",ni,nj);
+        exit(1);
+    }
+    lineMax = std::max(1,std::min(lineMax,ni));
+    lineMin = std::max(1,std::min(lineMin,lineMax));
+}
+
+/* [0,1) from (seed, stream, index) */
+double Generator::uniform(int stream,size_t index) const {
+    const unsigned long long h = mix(mix(seed*0x100000001b3ULL + stream) ^ index);
+    return (h >> 11)*(1.0/9007199254740992.0);
+}
+
+std::string Generator::name() const {
+    return std::string("gen-") + ((grid == GEN_BOUNDARY_LAYER) ? "bl":"structured")
+         + "-" + std::to_string(ni) + "x" + std::to_string(nj);
+}
+
+void Generator::generateMesh(){
+    nelem = ni*nj;
+    const int nfi = (ni-1)*nj;      /* in-line (i) faces first */
+    nintface = nfi + ni*(nj-1);
+    eftot = 4*nelem;
+
+    /* element numbering: grid cell (i,j) -> element */
+    std::vector<int> perm(nelem),iperm(nelem);
+    for(int n = 0; n < nelem; ++n) perm[n] = n;
+    if(shuffle){
+        for(int n = nelem-1; n > 0; --n){
+            const int k = (int) (uniform(GEN_PERM,n)*(n+1));
+            std::swap(perm[n],perm[std::min(k,n)]);
+        }
+    }
+    for(int n = 0; n < nelem; ++n) iperm[perm[n]] = n;
+
+    auto cell  = [&](int i,int j){return perm[i + (size_t) ni*j];};
+    auto iface = [&](int i,int j){return i + (ni-1)*j;};          /* (i,j)-(i+1,j) */
+    auto jface = [&](int i,int j){return nfi + i + ni*j;};        /* (i,j)-(i,j+1) */
+
+    /* faces of each element: i-, i+, j-, j+ (boundaries: wall, far field, sides) */
+    epoint.resize(nelem+1);
+    ef.resize(eftot);
+    #pragma omp parallel for schedule(static)
+    for(int e = 0; e < nelem; ++e){
+        const int i = iperm[e] % ni;
+        const int j = iperm[e] / ni;
+        int *f = &ef[4*(size_t) e];
+        epoint[e] = 4*e;
+        f[0] = (i > 0)    ? iface(i-1,j):boundary(j);
+        f[1] = (i < ni-1) ? iface(i,j)  :boundary(nj+j);
+        f[2] = (j > 0)    ? jface(i,j-1):boundary(2*nj+i);
+        f[3] = (j < nj-1) ? jface(i,j)  :boundary(2*nj+ni+i);
+    }
+    epoint[nelem] = eftot;
+
+    fc.resize(2*(size_t) nintface);
+    #pragma omp parallel for schedule(static)
+    for(int j = 0; j < nj; ++j){
+        for(int i = 0; i < ni; ++i){
+            if(i < ni-1){
+                fc[2*(size_t) iface(i,j)+0] = cell(i,j);
+                fc[2*(size_t) iface(i,j)+1] = cell(i+1,j);
+            }
+            if(j < nj-1){
+                fc[2*(size_t) jface(i,j)+0] = cell(i,j);
+                fc[2*(size_t) jface(i,j)+1] = cell(i,j+1);
+            }
+        }
+    }
+
+    /* lines: wall-normal segments of each column, lengths drawn per segment;
+     * boundary-layer grids keep the wall segment and leave the rest pointwise */
+    linesize.clear();
+    lines.resize(nelem);
+    lineface.resize(nelem);
+    inline_face.assign(nintface,0);
+    int m = 0;
+    for(int j = 0; j < nj; ++j){
+        for(int i = 0; i < ni;){
+            const double u = std::pow(uniform(GEN_LEN,(size_t) ni*j + i),skew);
+            int len = lineMin + (int) (u*(lineMax - lineMin + 1));
+            len = std::min(std::min(len,lineMax),ni-i);
+            if(grid == GEN_BOUNDARY_LAYER && i > 0) len = 1;
+
+            for(int k = 0; k < len; ++k, ++m){
+                lines[m] = cell(i+k,j);
+                if(k == 0){
+                    lineface[m] = (i == 0) ? boundary(j):-1;
+                } else {
+                    lineface[m] = iface(i+k-1,j);
+                    inline_face[iface(i+k-1,j)] = 1;
+                }
+            }
+            linesize.push_back(len);
+            i += len;
+        }
+    }
+    nline = linesize.size();
+    nlineelem = m;
+
+    linepoint.resize(nline+1);
+    linepoint[0] = 0;
+    max_line_nelem = 0;
+    for(int l = 0; l < nline; ++l){
+        linepoint[l+1] = linepoint[l] + linesize[l];
+        max_line_nelem = std::max(max_line_nelem,linesize[l]);
+    }
+
+    printf("\x1B[1;92mGenerated %s\x1B[0m\n",name().c_str());
+    printf("  nelem: %d, nintface: %d, nline: %d (mean length %.2f, max %d)\n",
+           nelem,nintface,nline,(double) nlineelem/nline,max_line_nelem);
+}
+
+void Generator::generateBlocks(int _nvar){
+    nvar = _nvar;
+    const size_t nblk = (size_t) nvar*nvar;
+
+    /* face blocks: in-line couplings scaled by aniso */
+    jacO1.resize(nblk*nintface);
+    jacO2.resize(nblk*nintface);
+    #pragma omp parallel for schedule(static)
+    for(int f = 0; f < nintface; ++f){
+        const double scale = inline_face[f] ? aniso:1.0;
+        for(size_t q = 0; q < nblk; ++q){
+            jacO1[nblk*f + q] = scale*(2.0*uniform(GEN_O1,nblk*f + q) - 1.0);
+            jacO2[nblk*f + q] = scale*(2.0*uniform(GEN_O2,nblk*f + q) - 1.0);
+        }
+    }
+
+    /* diagonal blocks: diagonal = dominance * off-diagonal row sum of [D] and the row's face blocks */
+    jacD.resize(nblk*nelem);
+    rhs.resize((size_t) nvar*nelem);
+    #pragma omp parallel for schedule(static)
+    for(int e = 0; e < nelem; ++e){
+        double *D = &jacD[nblk*e];
+        for(int j = 0; j < nvar; ++j){
+            for(int i = 0; i < nvar; ++i){
+                D[i + nvar*j] = (i == j) ? 0.0:2.0*uniform(GEN_D,nblk*e + i + nvar*j) - 1.0;
+            }
+        }
+
+        for(int i = 0; i < nvar; ++i){
+            double sum = 0.0;
+            for(int j = 0; j < nvar; ++j) sum += std::fabs(D[i + nvar*j]);
+            for(int k = epoint[e]; k < epoint[e+1]; ++k){
+                const int f = ef[k];
+                if(f < 0) continue;
+                const double *O = (e == fc[2*(size_t) f]) ? &jacO2[nblk*f]:&jacO1[nblk*f];
+                for(int j = 0; j < nvar; ++j) sum += std::fabs(O[i + nvar*j]);
+            }
+            D[i + nvar*i] = (sum > 0.0) ? dominance*sum:1.0;
+            rhs[(size_t) nvar*e + i] = 2.0*uniform(GEN_RHS,(size_t) nvar*e + i) - 1.0;
+        }
+    }
+}
+
+/* in-place views: the Generator must outlive mesh */
+void Generator::toMesh(Mesh &mesh){
+    mesh.fromArrays(nelem,nintface,eftot,epoint.data(),ef.data(),fc.data(),
+                    nline,nlineelem,linesize.data(),linepoint.data(),lines.data(),lineface.data(),0);
+    mesh.nvar = nvar;
+    mesh.printStats();
+}
+
+/* in-place views: zero initial guess, tri-block A packed by assembleTriBlocks */
+void Generator::toJacobian(Jacobian &Jac){
+    Jac.fromArrays(nvar,nelem,nintface,jacD.data(),jacO1.data(),jacO2.data(),rhs.data());
+    Jac.printStats();
+}
+
+/* nrhs right-hand sides (nvar,nrhs,nelem) from the single rhs of Jac
+ * for nrhs>1 runs: column r scales each variable so the systems differ
+ * (r = 0 unchanged) */
+std::vector<double> Generator::batchRhs(const Jacobian &Jac,int nrhs){
+    const int nvar = Jac.nvar;
+    std::vector<double> B((size_t) nvar*nrhs*Jac.nelem);
+    for(int e = 0; e < Jac.nelem; ++e){
+        for(int r = 0; r < nrhs; ++r){
+            for(int i = 0; i < nvar; ++i){
+                B[i + (size_t) nvar*(r + (size_t) nrhs*e)] =
+                    Jac.rhs[(size_t) nvar*e + i]*(1.0 + 0.5*sin((double) r*(i+1)));
+            }
+        }
+    }
+    return B;
+}
+
+/* 0-based index record -> 1-based file record */
+static void writeIndex(FILE *fp,const std::vector<int> &v,int base){
+    std::vector<int> chunk;
+    for(size_t n = 0; n < v.size(); n += (1 << 20)){
+        const size_t count = std::min(v.size() - n,(size_t) 1 << 20);
+        chunk.resize(count);
+        for(size_t k = 0; k < count; ++k) chunk[k] = v[n+k] + base;
+        fwrite(chunk.data(),sizeof(int),count,fp);
+    }
+}
+
+bool Generator::writeLegacy(const std::string &meshName,const std::string &jacName) const {
+    FILE *fp = fopen(meshName.c_str(),"wb");
+    if(fp == nullptr){
+        printf("\x1B[1;31mERROR: could not open %s for writing\x1B[0m\n",meshName.c_str());
+        return false;
+    }
+    const int mesh_data[6] = {nvar,nelem,nintface,eftot,nline,nlineelem};
+    fwrite(mesh_data,sizeof(int),6,fp);
+    writeIndex(fp,epoint,1);
+    writeIndex(fp,ef,1);
+    writeIndex(fp,fc,1);
+    writeIndex(fp,linesize,0);
+    writeIndex(fp,linepoint,1);
+    writeIndex(fp,lines,1);
+    writeIndex(fp,lineface,1);
+    fclose(fp);
+
+    fp = fopen(jacName.c_str(),"wb");
+    if(fp == nullptr){
+        printf("\x1B[1;31mERROR: could not open %s for writing\x1B[0m\n",jacName.c_str());
+        return false;
+    }
+    const int jac_data[3] = {nvar,nelem,nintface};
+    fwrite(jac_data,sizeof(int),3,fp);
+    fwrite(jacD.data(),sizeof(double),jacD.size(),fp);
+    fwrite(jacO1.data(),sizeof(double),jacO1.size(),fp);
+    fwrite(jacO2.data(),sizeof(double),jacO2.size(),fp);
+    fwrite(rhs.data(),sizeof(double),rhs.size(),fp);
+    const std::vector<double> zero(std::min(rhs.size(),(size_t) 1 << 20),0.0);
+    for(size_t n = 0; n < rhs.size(); n += zero.size()){
+        fwrite(zero.data(),sizeof(double),std::min(zero.size(),rhs.size() - n),fp);
+    }
+    fclose(fp);
+    return true;
+}
+
+bool Generator::writeTriBlock(const std::string &fileName) const {
+    TriBlockHeader hdr;
+    memset(&hdr,0,sizeof(hdr));
+    hdr.nvar = nvar;
+    hdr.nelem = nelem;
+    hdr.nintface = nintface;
+    hdr.eftot = eftot;
+    hdr.nline = nline;
+    hdr.nlineelem = nlineelem;
+    hdr.max_line_nelem = max_line_nelem;
+
+    const std::vector<double> U0(rhs.size(),0.0);
+    const void *data[SEC_COUNT] = {nullptr};
+    size_t bytes[SEC_COUNT] = {0};
+    auto add = [&](int id,const void *ptr,size_t nbytes){data[id] = ptr; bytes[id] = nbytes;};
+
+    add(SEC_EPOINT,   epoint.data(),   epoint.size()*sizeof(int));
+    add(SEC_EF,       ef.data(),       ef.size()*sizeof(int));
+    add(SEC_FC,       fc.data(),       fc.size()*sizeof(int));
+    add(SEC_LINESIZE, linesize.data(), linesize.size()*sizeof(int));
+    add(SEC_LINEPOINT,linepoint.data(),linepoint.size()*sizeof(int));
+    add(SEC_LINES,    lines.data(),    lines.size()*sizeof(int));
+    add(SEC_LINEFACE, lineface.data(), lineface.size()*sizeof(int));
+    add(SEC_JACD,     jacD.data(),     jacD.size()*sizeof(double));
+    add(SEC_JACO1,    jacO1.data(),    jacO1.size()*sizeof(double));
+    add(SEC_JACO2,    jacO2.data(),    jacO2.size()*sizeof(double));
+    add(SEC_RHS,      rhs.data(),      rhs.size()*sizeof(double));
+    add(SEC_U0,       U0.data(),       U0.size()*sizeof(double));
+
+    return TriBlockFile::write(fileName,hdr,data,bytes);
+}
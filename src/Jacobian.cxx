@@ -7,46 +7,176 @@
 
 /* header files */
 #include "Jacobian.hxx"
+#include "TriBlockFile.hxx"
 
-bool Jacobian::fromFile(int nlineelem){
+/* system header files */
+#include <algorithm>
+
+/* upload a host array, streaming straight from the mapped pages if it is a view */
+static void upload(occa::memory &o_mem,const HostArray<double> &h,const MappedFile &file){
+    uploadChunked(o_mem,h.data(),h.size(),h.isView() ? &file:nullptr);
+}
+
+/* asynchronous upload of blocks ids (blk entries each); adjacent ids
+ * are merged into one copy */
+static void uploadRuns(occa::memory &o_mem,const double *h,std::vector<int> ids,size_t blk){
+    std::sort(ids.begin(),ids.end());
+    ids.erase(std::unique(ids.begin(),ids.end()),ids.end());
+
+    for(size_t n = 0; n < ids.size(); ){
+        size_t n2 = n + 1;
+        while(n2 < ids.size() && ids[n2] == ids[n2-1] + 1) ++n2;
+
+        const size_t offset = blk*ids[n];
+        o_mem.copyFrom(h + offset,blk*(n2 - n),offset,occa::properties("{async: true}"));
+        n = n2;
+    }
+}
+
+bool Jacobian::fromFile(int nlineelem,const std::string &fileName){
     int jac_data[3];
 
-    /* read Jacobian size data from file */
-    FILE *fp = fopen("gpuline.jacobian.data.bin", "rb");
-    if(fp == nullptr){
-        printf("\x1B[1;31mERROR: could not find gpuline.jacobian.data.bin\x1B[0m\n");
+    /* map Jacobian data file */
+    if(!jacFile.open(fileName)){
+        printf("\x1B[1;31mERROR: could not find %s\x1B[0m\n",fileName.c_str());
         exit(1);
     } else {
-        printf("\x1B[1;92mReading gpuline.jacobian.data.bin\x1B[0m\n");
+        printf("\x1B[1;92mReading %s\x1B[0m\n",fileName.c_str());
+    }
+
+    /* versioned format: sections are aligned and ready to upload */
+    if(TriBlockFile::isTriBlock(jacFile)) return fromTriBlockFile(nlineelem);
+
+    if(jacFile.size() < sizeof(jac_data)){
+        printf("\x1B[1;31mERROR: %s is truncated\x1B[0m\n",fileName.c_str());
+        exit(1);
     }
-    size_t nread = fread(jac_data,sizeof(jac_data),1,fp);
-    fclose(fp);
+    memcpy(jac_data,jacFile.ptr<int>(0),sizeof(jac_data));
 
     nvar     = jac_data[0];
     nelem    = jac_data[1];
     nintface = jac_data[2];
 
-    /* mesh sizes */
-    std::cout << "Read Jac Stats:\n";
-    printf("  nvar: %d\n"
-           "  nelem: %d\n"
-           "  nintface: %d\n",
-           nvar,nelem,nintface);
+    printStats();
+
+    /* check record sizes against the header */
+    const size_t nblk = (size_t) nvar*nvar;
+    const size_t ndiag = nblk*nelem;
+    const size_t noffd = nblk*nintface;
+    const size_t nvec = (size_t) nvar*nelem;
+    const size_t expected = sizeof(jac_data) + (ndiag + 2*noffd + 2*nvec)*sizeof(double);
+
+    if(nvar <= 0 || nelem < 0 || nintface < 0 || jacFile.size() != expected){
+        printf("\x1B[1;31mERROR: %s size %zu does not match header (%zu bytes)\x1B[0m\n",
+               fileName.c_str(),jacFile.size(),expected);
+        exit(1);
+    }
+
+    /* point the file-backed arrays at their records (no host copy):
+     *   the legacy stream has a 12-byte header, so records are only
+     *   4-byte aligned; x86/ARM64 hosts and device DMA tolerate this */
+    size_t offset = sizeof(jac_data);
+    jacD.wrap(jacFile.ptr<double>(offset),ndiag);  offset += ndiag*sizeof(double);
+    jacO1.wrap(jacFile.ptr<double>(offset),noffd); offset += noffd*sizeof(double);
+    jacO2.wrap(jacFile.ptr<double>(offset),noffd); offset += noffd*sizeof(double);
+    rhs.wrap(jacFile.ptr<double>(offset),nvec);    offset += nvec*sizeof(double);
+    U0.wrap(jacFile.ptr<double>(offset),nvec);     offset += nvec*sizeof(double);
+
+    allocate(nlineelem);
+    std::cout << "Read Jacobian Data Complete!\n";
+    return true;
+}
+
+bool Jacobian::fromTriBlockFile(int nlineelem){
+    TriBlockFile tbk;
+    if(!tbk.read(jacFile,TRIBLOCK_SECTIONS_JAC)) exit(1);
+
+    nvar     = tbk.header.nvar;
+    nelem    = tbk.header.nelem;
+    nintface = tbk.header.nintface;
+    printStats();
+
+    tbk.wrap(jacD,jacFile,SEC_JACD);
+    tbk.wrap(jacO1,jacFile,SEC_JACO1);
+    tbk.wrap(jacO2,jacFile,SEC_JACO2);
+    tbk.wrap(rhs,jacFile,SEC_RHS);
+    tbk.wrap(U0,jacFile,SEC_U0);
 
+    /* precomputed tri-block packing: assembleTriBlocks becomes a no-op */
+    if(tbk.has(SEC_A)) tbk.wrap(A,jacFile,SEC_A);
+
+    allocate(nlineelem);
+    std::cout << "Read Jacobian Data Complete!\n";
+    return true;
+}
+
+/* caller-owned host blocks (library API): viewed in place, like the
+ * mapped file records; the packed A covers every element */
+void Jacobian::fromArrays(int _nvar,int _nelem,int _nintface,
+                          const double *D,const double *O1,const double *O2,const double *b){
+    nvar     = _nvar;
+    nelem    = _nelem;
+    nintface = _nintface;
+
+    const size_t nblk = (size_t) nvar*nvar;
+    jacD.wrap(const_cast<double*>(D),nblk*nelem);
+    jacO1.wrap(const_cast<double*>(O1),nblk*nintface);
+    jacO2.wrap(const_cast<double*>(O2),nblk*nintface);
+    rhs.wrap(const_cast<double*>(b),(size_t) nvar*nelem);
+    nrhs = 1;
+    U0 = HostArray<double>();
+    A = HostArray<double>();
+
+    allocate(nelem);
+}
+
+/* caller-owned device blocks (library API): used in place, no host copy.
+ * Runs the low-memory kernels (no packed A); factor copies o_jacD into
+ * o_jacDLU on the device */
+void Jacobian::wrapDevice(Platform &gpu,int _nvar,int _nelem,int _nintface,
+                          occa::memory &o_D,occa::memory &o_O1,occa::memory &o_O2,occa::memory &o_b){
+    nvar     = _nvar;
+    nelem    = _nelem;
+    nintface = _nintface;
+    lowmem   = 1;
+    nrhs     = 1;
+
+    jacD = HostArray<double>();
+    jacO1 = HostArray<double>();
+    jacO2 = HostArray<double>();
+    rhs = HostArray<double>();
+    U0 = HostArray<double>();
+    A = HostArray<double>();
+    jacDLU.clear();
+    DinvC.clear();
+    U.clear();
+    dU.clear();
+    res.clear();
+    nbytes = 0;
+
+    o_jacD  = o_D;
+    o_jacO1 = o_O1;
+    o_jacO2 = o_O2;
+    o_rhs   = o_b;
+
+    const size_t nblk = (size_t) nvar*nvar;
+    o_jacDLU   = gpu.malloc<double>(nblk*nelem);
+    o_jacDinvC = gpu.malloc<double>(nblk*nelem);
+    o_U   = gpu.malloc<double>((size_t) nvar*nelem);
+    o_dU  = gpu.malloc<double>((size_t) nvar*nelem);
+    o_res = gpu.malloc<double>((size_t) nvar*nelem);
+}
+
+void Jacobian::allocate(int nlineelem){
     /* allocate host Jacobian data */
     jacDLU.resize(nvar*nvar*nelem);
-    jacD.resize(nvar*nvar*nelem);
-    jacO1.resize(nvar*nvar*nintface);
-    jacO2.resize(nvar*nvar*nintface);
-    rhs.resize(nvar*nelem);
-    U0.resize(nvar*nelem);
 
     U.resize(nvar*nelem);
     dU.resize(nvar*nelem);
     res.resize(nvar*nelem);
 
     DinvC.resize(nvar*nvar*nelem);
-    A.resize(nvar*nvar*nlineelem);
+    if(!A.isView()) A.resize(nvar*nvar*nlineelem);
   //B.resize(nvar*nvar*nlineelem);
   //C.resize(nvar*nvar*nlineelem);
   //offmap.resize(nlineelem);
@@ -64,16 +194,20 @@ bool Jacobian::fromFile(int nlineelem){
     for(auto i:res) i = 0.0;
     for(auto i:dU) i = 0.0;
     for(auto i:U) i = 0.0;
+}
 
-    /* read arrays using fortran */
-    read_jacobian_data_(&nvar,&nelem,&nintface,
-                        jacD.data(),jacO1.data(),jacO2.data(),
-                        rhs.data(),U0.data());
-    std::cout << "Read Jacobian Data Complete!\n";
-    return true;
+void Jacobian::printStats(){
+    /* mesh sizes */
+    std::cout << "Read Jac Stats:\n";
+    printf("  nvar: %d\n"
+           "  nelem: %d\n"
+           "  nintface: %d\n",
+           nvar,nelem,nintface);
 }
 
 void Jacobian::assembleTriBlocks(Mesh &mesh){
+    /* packed blocks were loaded from a TriBlock file */
+    if(A.isView()) return;
 
 //    int ind = 0;
 //    for(int k = 0; k < mesh.max_line_nelem; k++){
@@ -160,11 +294,11 @@ void Jacobian::resizeBlockSize(int nvar_new){
     nvar = nvar_new;
     int min_nvar = (nvar < nvar_old) ? nvar:nvar_old;
 
-    std::vector<double> jacD_old(jacD);
-    std::vector<double> jacO1_old(jacO1);
-    std::vector<double> jacO2_old(jacO2);
-    std::vector<double> rhs_old(rhs);
-    std::vector<double> U0_old(U0);
+    std::vector<double> jacD_old(jacD.begin(),jacD.end());
+    std::vector<double> jacO1_old(jacO1.begin(),jacO1.end());
+    std::vector<double> jacO2_old(jacO2.begin(),jacO2.end());
+    std::vector<double> rhs_old(rhs.begin(),rhs.end());
+    std::vector<double> U0_old(U0.begin(),U0.end());
 
     jacD.resize(nvar*nvar*nelem);
     jacO1.resize(nvar*nvar*nintface);
@@ -237,14 +371,71 @@ void Jacobian::resizeBlockSize(int nvar_new){
     printf(" done!\n");
 }
 
+/* permute element-indexed blocks/vectors into the mesh slot order
+ * (Mesh::reorderLines); padding slots get identity diagonals. Views of
+ * caller arrays (fromArrays) become owned slot-ordered copies */
+void Jacobian::reorderLines(const Mesh &mesh){
+    if(!mesh.interleave) return;
+
+    const size_t nblk = (size_t) nvar*nvar;
+    const int nslot = mesh.nelem;
+    const int nA = A.size()/nblk;
+
+    std::vector<double> jacD_new(nblk*nslot,0.0);
+    std::vector<double> A_new(nblk*nslot,0.0);
+    std::vector<double> rhs_new((size_t) nvar*nslot,0.0);
+    std::vector<double> U0_new(U0.size() ? (size_t) nvar*nslot:0,0.0);
+
+    #pragma omp parallel for schedule(static)
+    for(int s = 0; s < nslot; ++s){
+        const int e = mesh.slotelem[s];
+        if(e < 0){
+            for(int i = 0; i < nvar; ++i) jacD_new[nblk*s + nvar*i + i] = 1.0;
+            continue;
+        }
+        std::copy(&jacD[nblk*e],&jacD[nblk*(e+1)],&jacD_new[nblk*s]);
+        if(e < nA) std::copy(&A[nblk*e],&A[nblk*(e+1)],&A_new[nblk*s]);
+        std::copy(&rhs[(size_t) nvar*e],&rhs[(size_t) nvar*(e+1)],&rhs_new[(size_t) nvar*s]);
+        if(U0.size()) std::copy(&U0[(size_t) nvar*e],&U0[(size_t) nvar*(e+1)],&U0_new[(size_t) nvar*s]);
+    }
+
+    nelem = nslot;
+    jacD = HostArray<double>(); jacD.resize(jacD_new.size());
+    A    = HostArray<double>(); A.resize(A_new.size());
+    rhs  = HostArray<double>(); rhs.resize(rhs_new.size());
+    U0   = HostArray<double>(); U0.resize(U0_new.size());
+    std::copy(jacD_new.begin(),jacD_new.end(),jacD.begin());
+    std::copy(A_new.begin(),A_new.end(),A.begin());
+    std::copy(rhs_new.begin(),rhs_new.end(),rhs.begin());
+    std::copy(U0_new.begin(),U0_new.end(),U0.begin());
+
+    jacDLU.assign(nblk*nslot,0.0);
+    DinvC.assign(nblk*nslot,0.0);
+    U.assign((size_t) nvar*nslot,0.0);
+    dU.assign((size_t) nvar*nslot,0.0);
+    res.assign((size_t) nvar*nslot,0.0);
+}
+
+/* batch of the caller's nrhs right-hand sides B(nvar,nrhs,nelem),
+ * copied; U, dU and res take the same layout (zero initial guess) */
+void Jacobian::setNrhs(int nrhs_new,const double *B){
+    const size_t n = (size_t) nvar*nrhs_new*nelem;
+
+    nrhs = nrhs_new;
+    rhs = HostArray<double>(); rhs.resize(n);
+    std::copy(B,B + n,rhs.begin());
+
+    U.assign(n,0.0);
+    dU.assign(n,0.0);
+    res.assign(n,0.0);
+}
+
 void Jacobian::setupDevice(Platform &gpu){
     /* allocate device memory */
     o_jacDLU = gpu.malloc<double>(jacDLU.size());
-    o_jacD = gpu.malloc<double>(jacD.size());
     o_jacO1 = gpu.malloc<double>(jacO1.size());
     o_jacO2 = gpu.malloc<double>(jacO2.size());
     o_rhs = gpu.malloc<double>(rhs.size());
-    o_U0 = gpu.malloc<double>(U0.size());
 
     o_jacDinvC = gpu.malloc<double>(jacDLU.size());
 
@@ -252,37 +443,147 @@ void Jacobian::setupDevice(Platform &gpu){
     o_dU = gpu.malloc<double>(dU.size());
     o_res = gpu.malloc<double>(res.size());
 
-    o_A = gpu.malloc<double>(A.size());
+    /* low-memory mode: jacD is factored in place in o_jacDLU, A is read
+     * from o_jacO1/o_jacO2 through lineface, and U0 is never read */
+    if(!lowmem){
+        o_jacD = gpu.malloc<double>(jacD.size());
+        o_A = gpu.malloc<double>(A.size());
+        if(U0.size()) o_U0 = gpu.malloc<double>(U0.size());
+    } else {
+        o_jacD = occa::memory();
+    }
   //o_B = gpu.malloc<double>(B.size());
   //o_C = gpu.malloc<double>(C.size());
   //o_offmap= gpu.malloc<int>(offmap.size());
 }
 
+/* upload changed host blocks only: jacD of elems, jacO1/jacO2 of faces
+ * (lowmem: jacD is re-read from the host when its lines are refactored) */
+void Jacobian::updateBlocks(const std::vector<int> &elems,const std::vector<int> &faces){
+    const size_t nblk = (size_t) nvar*nvar;
+
+    if(!lowmem) uploadRuns(o_jacD,jacD.data(),elems,nblk);
+    uploadRuns(o_jacO1,jacO1.data(),faces,nblk);
+    uploadRuns(o_jacO2,jacO2.data(),faces,nblk);
+}
+
+/* re-pack A (see assembleTriBlocks) for elems and upload those blocks */
+void Jacobian::repackTriBlocks(const Mesh &mesh,const std::vector<int> &elems){
+    const size_t nblk = (size_t) nvar*nvar;
+
+    std::vector<int> packed;
+    for(const int e: elems){
+        const int m = mesh.elemlinepos[e];
+        if(m < 0 || m == mesh.linepoint[mesh.elemline[e]]) continue;
+
+        const int f = mesh.lineface[m];
+        const int e1 = mesh.fc[2*f];
+        const double *Aptr = (e==e1) ? &jacO2[nblk*f]:&jacO1[nblk*f];
+        memcpy(&A[nblk*e],Aptr,nblk*sizeof(double));
+        packed.push_back(e);
+    }
+    if(!lowmem) uploadRuns(o_A,A.data(),packed,nblk);
+}
+
+/* lowmem: unfactored jacD blocks of elems back into o_jacDLU */
+void Jacobian::restoreDiag(const std::vector<int> &elems){
+    uploadRuns(o_jacDLU,jacD.data(),elems,(size_t) nvar*nvar);
+}
+
+size_t Jacobian::lowmemSavedBytes() const {
+    return (jacD.size() + U0.size() + A.size())*sizeof(double);
+}
+
 void Jacobian::toDevice(){
-    o_jacDLU.copyFrom(jacDLU.data());
-    o_jacD.copyFrom(jacD.data());
-    o_jacO1.copyFrom(jacO1.data());
-    o_jacO2.copyFrom(jacO2.data());
-    o_rhs.copyFrom(rhs.data());
-    o_U0.copyFrom(U0.data());
+    if(lowmem){
+        upload(o_jacDLU,jacD,jacFile);
+    } else {
+        o_jacDLU.copyFrom(jacDLU.data());
+        upload(o_jacD,jacD,jacFile);
+        upload(o_U0,U0,jacFile);
+        upload(o_A,A,jacFile);
+    }
+    upload(o_jacO1,jacO1,jacFile);
+    upload(o_jacO2,jacO2,jacFile);
+    upload(o_rhs,rhs,jacFile);
 
     o_U.copyFrom(U.data());
     o_res.copyFrom(res.data());
     o_dU.copyFrom(dU.data());
 
-    o_A.copyFrom(A.data());
   //o_B.copyFrom(B.data());
   //o_C.copyFrom(C.data());
   //o_offmap.copyFrom(offmap.data());
 }
 
+/* elements/faces of part p of nparts (Transfer::split) of jacD, jacO1
+ * and jacO2, queued on the transfer stream */
+void Jacobian::blocksToDevice(Transfer &xfer,int p,int nparts){
+    const size_t nblk = (size_t) nvar*nvar;
+    const size_t e0 = nblk*Transfer::split(nelem,p,nparts);
+    const size_t e1 = nblk*Transfer::split(nelem,p+1,nparts);
+    const size_t f0 = nblk*Transfer::split(nintface,p,nparts);
+    const size_t f1 = nblk*Transfer::split(nintface,p+1,nparts);
+    const MappedFile *file = jacD.isView() ? &jacFile:nullptr;
+
+    /* lowmem: jacD is factored in place in o_jacDLU */
+    xfer.upload(lowmem ? o_jacDLU:o_jacD,jacD.data()+e0,e1-e0,e0,file);
+    xfer.upload(o_jacO1,jacO1.data()+f0,f1-f0,f0,jacO1.isView() ? &jacFile:nullptr);
+    xfer.upload(o_jacO2,jacO2.data()+f0,f1-f0,f0,jacO2.isView() ? &jacFile:nullptr);
+}
+
+/* everything but the blocks, queued on the transfer stream */
+void Jacobian::vectorsToDevice(Transfer &xfer){
+    if(!lowmem){
+        xfer.upload(o_jacDLU,jacDLU);
+        xfer.upload(o_U0,U0,jacFile);
+        xfer.upload(o_A,A,jacFile);
+    }
+    xfer.upload(o_rhs,rhs,jacFile);
+
+    xfer.upload(o_U,U);
+    xfer.upload(o_res,res);
+    xfer.upload(o_dU,dU);
+}
+
+void Jacobian::toDevice(Transfer &xfer){
+    vectorsToDevice(xfer);
+    blocksToDevice(xfer,0,1);
+}
+
+/* queued on the transfer stream once the compute stream is done with U;
+ * the host copy is valid after xfer.finish(), in slot order on a
+ * line-ordered mesh (Mesh::toNative maps it to elements) */
+void Jacobian::downloadSolution(Transfer &xfer){
+    xfer.wait(xfer.gpu.device.tagStream());
+    xfer.download(U.data(),o_U,U.size());
+}
+
+void Jacobian::fromDevice(Transfer &xfer){
+    xfer.wait(xfer.gpu.device.tagStream());
+    xfer.download(jacDLU.data(),o_jacDLU,jacDLU.size());
+    xfer.download(jacO1.data(),o_jacO1,jacO1.size());
+    xfer.download(jacO2.data(),o_jacO2,jacO2.size());
+    xfer.download(rhs.data(),o_rhs,rhs.size());
+    if(!lowmem){
+        xfer.download(jacD.data(),o_jacD,jacD.size());
+        xfer.download(U0.data(),o_U0,U0.size());
+    }
+
+    xfer.download(U.data(),o_U,U.size());
+    xfer.download(dU.data(),o_dU,dU.size());
+    xfer.download(res.data(),o_res,res.size());
+}
+
 void Jacobian::fromDevice(){
     o_jacDLU.copyTo(jacDLU.data());
-    o_jacD.copyTo(jacD.data());
     o_jacO1.copyTo(jacO1.data());
     o_jacO2.copyTo(jacO2.data());
     o_rhs.copyTo(rhs.data());
-    o_U0.copyTo(U0.data());
+    if(!lowmem){
+        o_jacD.copyTo(jacD.data());
+        if(U0.size()) o_U0.copyTo(U0.data());
+    }
 
     o_U.copyTo(U.data());
     o_dU.copyTo(dU.data());
@@ -0,0 +1,126 @@
+/**
+ * \file    KernelCache.cxx
+ * \author  akirby
+ *
+ * \brief KernelCache class implementation
+ */
+
+/* header files */
+#include "KernelCache.hxx"
+#include "LineSolver.hxx"
+#include "BlockCodegen.hxx"
+
+/* system header files */
+#include <fstream>
+
+KernelCache::KernelCache(Platform &_gpu):
+    gpu(_gpu)
+{
+    manifest = manifestPath(occa::env::OCCA_CACHE_DIR);
+}
+
+std::string KernelCache::manifestPath(const std::string &cacheDir){
+    std::string dir = cacheDir;
+    while(dir.size() > 1 && dir.back() == '/') dir.pop_back();
+    return dir + "/" KERNEL_MANIFEST_NAME;
+}
+
+std::string KernelCache::comboKey(occa::device &device,int nvar,int maxLineElem,const Options &opts){
+    const std::string arch = device.arch();
+    return "mode=" + device.mode()
+         + (arch.empty() ? "":";arch=" + arch)
+         + ";nvar=" + std::to_string(nvar)
+         + ";max_line_elem=" + std::to_string(maxLineElem)
+         + ";unroll=" + std::to_string(opts.getInt("unroll",1))
+         + ";vec_block=" + std::to_string(opts.getInt("vec_block",256));
+}
+
+std::vector<KernelCache::Spec> KernelCache::kernelSet(int nvar,int maxLineElem,const Options &opts){
+    /* same files, kernels and properties as LineSolver::setup/Convergence::setup */
+    const occa::properties base = LineSolver::baseProperties(nvar,maxLineElem);
+    std::vector<Spec> set;
+
+    occa::properties vecProps = base;
+    vecProps["defines/p_blockSize"] = opts.getInt("vec_block",256);
+    set.push_back({SOLVER_DIR "/okl/linesmoothLU_v5.okl","copyAtoBjac",vecProps});
+    set.push_back({SOLVER_DIR "/okl/linesmoothLU_v5.okl","copyAtoB",vecProps});
+    set.push_back({SOLVER_DIR "/okl/linesmoothLU_v5.okl","addAtoB",vecProps});
+
+    if(opts.getInt("unroll",1)){
+        occa::properties blockProps = base;
+        BlockCodegen::define(blockProps,nvar);
+        occa::properties listProps = blockProps;
+        listProps["defines/p_LineList"] = 1;
+        set.push_back({SOLVER_DIR "/okl/lineLU_v5.okl","lineLU",blockProps});
+        set.push_back({SOLVER_DIR "/okl/lineLU_v5.okl","lineLU",listProps});
+        set.push_back({SOLVER_DIR "/okl/linesmoothLU_TriBlock_v12.okl","triblock_solveDU",blockProps});
+        set.push_back({SOLVER_DIR "/okl/linesmoothLU_TriBlock_v12.okl","triblock_lineRes",blockProps});
+    } else {
+        set.push_back({SOLVER_DIR "/okl/lineLU_v2.okl","lineLU",base});
+        set.push_back({SOLVER_DIR "/okl/linesmoothLU_TriBlock_v3.okl","triblock_solveDU",base});
+        set.push_back({SOLVER_DIR "/okl/linesmoothLU_TriBlock_v3.okl","triblock_lineRes",base});
+        set.push_back({SOLVER_DIR "/okl/lineLU_v4.okl","lineLU",base});
+    }
+    set.push_back({SOLVER_DIR "/okl/lineLU_v4.okl","lineCopy",base});
+
+    /* MPI runs: split residual and halo packing */
+    occa::properties partProps = base;
+    partProps["defines/p_Nres"] = std::max(1,256/nvar);
+    set.push_back({SOLVER_DIR "/okl/linesmoothLU_TriBlock_v8.okl","triblock_lineRes",partProps});
+    set.push_back({SOLVER_DIR "/okl/halo_v1.okl","haloPack",base});
+
+    /* residual norms */
+    set.push_back({SOLVER_DIR "/okl/residualNorm_v1.okl","residualNormPartial",occa::properties()});
+    set.push_back({SOLVER_DIR "/okl/residualNorm_v1.okl","residualNormFinal",occa::properties()});
+    return set;
+}
+
+bool KernelCache::listed(const std::string &manifest,const std::string &key){
+    std::ifstream in(manifest);
+    std::string line;
+    while(std::getline(in,line)){
+        if(line == key) return true;
+    }
+    return false;
+}
+
+bool KernelCache::warm(int nvar,int maxLineElem,const Options &opts){
+    if(gpu.mode == NATIVE_MODE) return false;
+
+    /* every rank must see the binaries (node-local caches) */
+    int hit = listed(manifest,comboKey(gpu.device,nvar,maxLineElem,opts));
+    MPI_Allreduce(MPI_IN_PLACE,&hit,1,MPI_INT,MPI_MIN,gpu.comm);
+    return hit;
+}
+
+void KernelCache::prefetch(int nvar,int maxLineElem,const Options &opts){
+    if(gpu.mode == NATIVE_MODE || gpu.rank) return;
+
+    const std::vector<Spec> specs = kernelSet(nvar,maxLineElem,opts);
+    const std::string key = comboKey(gpu.device,nvar,maxLineElem,opts);
+    const std::string setup = gpu.deviceSetup;
+    const std::string file = manifest;
+
+    /* private device: no state shared with the main thread's gpu.device */
+    worker = std::thread([specs,key,setup,file](){
+        occa::device device;
+        device.setup(setup);
+        build(device,specs,file,key);
+    });
+}
+
+void KernelCache::wait(){
+    if(worker.joinable()) worker.join();
+}
+
+void KernelCache::build(occa::device &device,const std::vector<Spec> &specs,
+                        const std::string &manifest,const std::string &key){
+    for(auto &s : specs){
+        device.buildKernel(s.file,s.name,s.props);
+    }
+
+    if(!listed(manifest,key)){
+        std::ofstream out(manifest,std::ios::app);
+        out << key << "\n";
+    }
+}
@@ -0,0 +1,214 @@
+/**
+ * \file    Krylov.cxx
+ * \author  akirby
+ *
+ * \brief Krylov class implementation
+ */
+
+/* header files */
+#include "Krylov.hxx"
+
+/* system header files */
+#include <cmath>
+
+void Krylov::setup(){
+    Jacobian &Jac = solver.Jac;
+
+    if(solver.fused){
+        printf("\x1B[1;31mERROR: solver=gmres/fgmres requires fused=0\x1B[0m\n");
+        exit(1);
+    }
+    if(gpu.nrank > 1){
+        printf("\x1B[1;31mERROR: solver=gmres/fgmres runs on a single MPI rank\x1B[0m\n");
+        exit(1);
+    }
+    if(restart < 1 || restart > 511){
+        printf("\x1B[1;31mERROR: restart=%d out of range [1,511]\x1B[0m\n",restart);
+        exit(1);
+    }
+
+    /* dot product block: p_Nkrylov columns x p_Ndot (power of 2) entries */
+    N = Jac.res.size();
+    nkrylov = restart + 1;
+    int ndot = 1;
+    while(2*ndot*nkrylov <= 1024) ndot *= 2;
+    nblocks = std::max(1,std::min(1024,(N + ndot - 1)/ndot));
+
+    occa::properties krylovProps = solver.kernelProps;
+    krylovProps["defines/p_Nkrylov"] = nkrylov;
+    krylovProps["defines/p_Ndot"] = ndot;
+
+    krylovSet       = gpu.buildKernel(SOLVER_DIR "/okl/krylov_v1.okl","krylovSet",krylovProps);
+    krylovScale     = gpu.buildKernel(SOLVER_DIR "/okl/krylov_v1.okl","krylovScale",krylovProps);
+    krylovAxpy      = gpu.buildKernel(SOLVER_DIR "/okl/krylov_v1.okl","krylovAxpy",krylovProps);
+    krylovDots      = gpu.buildKernel(SOLVER_DIR "/okl/krylov_v1.okl","krylovDots",krylovProps);
+    krylovDotsFinal = gpu.buildKernel(SOLVER_DIR "/okl/krylov_v1.okl","krylovDotsFinal",krylovProps);
+    krylovCombine   = gpu.buildKernel(SOLVER_DIR "/okl/krylov_v1.okl","krylovCombine",krylovProps);
+
+    /* device-resident basis; zeroed so padding slots stay zero */
+    o_V       = gpu.malloc<double>((size_t) N*nkrylov);
+    o_z       = gpu.malloc<double>(N);
+    o_pres    = gpu.malloc<double>(N);
+    o_pdU     = gpu.malloc<double>(N);
+    o_partial = gpu.malloc<double>(nblocks*nkrylov);
+    o_h       = gpu.malloc<double>(2*nkrylov+1);
+
+    krylovSet((size_t) N*nkrylov,0.0,o_V);
+    krylovSet((size_t) N,0.0,o_z);
+    krylovSet((size_t) N,0.0,o_pdU);
+    if(flexible){
+        o_Z = gpu.malloc<double>((size_t) N*restart);
+        krylovSet((size_t) N*restart,0.0,o_Z);
+    } else {
+        o_t = gpu.malloc<double>(N);
+    }
+
+    printf("%s(%d): %d line sweep(s) per preconditioner\n",
+           flexible ? "FGMRES":"GMRES",restart,pcSweeps);
+}
+
+occa::memory Krylov::col(occa::memory &o_basis,int i){
+    return o_basis.slice((size_t) i*N,N);
+}
+
+double Krylov::norm(occa::memory &o_x){
+    double nrm2;
+    krylovDots(N,1,nblocks,o_x,o_x,o_partial);
+    krylovDotsFinal(1,nblocks,o_partial,o_h);
+    o_h.copyTo(&nrm2,1);
+    return sqrt(nrm2);
+}
+
+void Krylov::precondition(occa::memory o_v,occa::memory o_zout){
+    /* z = M^(-1)*v: line-Jacobi sweeps on J*z = v from z = 0 */
+    krylovScale(N,-1.0,o_v,o_pres);
+    solver.solve(o_zout,o_pres);
+
+    for(int s = 1; s < pcSweeps; ++s){
+        krylovScale(N,-1.0,o_v,o_pres);
+        solver.residual(o_zout,o_pres);
+        solver.solve(o_pdU,o_pres);
+        krylovAxpy(N,1.0,o_pdU,o_zout);
+    }
+    ++nprec;
+}
+
+void Krylov::orthogonalize(int k,occa::memory &o_w,std::vector<double> &h){
+    std::vector<double> hbuf(2*nkrylov+1);
+    occa::memory o_h2 = o_h.slice(nkrylov,nkrylov);
+    occa::memory o_hn = o_h.slice(2*nkrylov,1);
+
+    /* CGS2: two projections against V(:,0:k) */
+    krylovDots(N,k,nblocks,o_V,o_w,o_partial);
+    krylovDotsFinal(k,nblocks,o_partial,o_h);
+    krylovCombine(N,k,-1.0,o_V,o_h,o_w);
+
+    krylovDots(N,k,nblocks,o_V,o_w,o_partial);
+    krylovDotsFinal(k,nblocks,o_partial,o_h2);
+    krylovCombine(N,k,-1.0,o_V,o_h2,o_w);
+
+    krylovDots(N,1,nblocks,o_w,o_w,o_partial);
+    krylovDotsFinal(1,nblocks,o_partial,o_hn);
+
+    /* one copy per Arnoldi step: Hessenberg column and ||w|| */
+    o_h.copyTo(hbuf.data());
+    for(int i = 0; i < k; ++i) h[i] = hbuf[i] + hbuf[nkrylov+i];
+    h[k] = sqrt(hbuf[2*nkrylov]);
+}
+
+int Krylov::solve(int maxIters){
+    Jacobian &Jac = solver.Jac;
+    const int ldh = restart + 1;
+
+    std::vector<double> H((size_t) ldh*restart);
+    std::vector<double> cs(restart),sn(restart);
+    std::vector<double> g(ldh),y(restart),h(ldh);
+
+    niter = 0;
+    nprec = 0;
+    converged = false;
+    history.clear();
+
+    double beta0 = 0.0;
+    while(true){
+        /* true residual: Jac.o_res = rhs + J*U = -(b - J*U) */
+        solver.reset();
+        solver.residual(Jac.o_U,Jac.o_res);
+        const double beta = norm(Jac.o_res);
+        resNorm = beta;
+
+        if(history.empty()){
+            beta0 = beta;
+            history.push_back(beta);
+        }
+        if(beta == 0.0 || beta <= tolAbs || beta <= tolRel*beta0){
+            converged = true;
+            break;
+        }
+        if(niter >= maxIters) break;
+
+        /* V(:,0) = r/||r|| */
+        occa::memory o_v0 = col(o_V,0);
+        krylovScale(N,-1.0/beta,Jac.o_res,o_v0);
+        std::fill(g.begin(),g.end(),0.0);
+        g[0] = beta;
+
+        /* Arnoldi cycle */
+        int j = 0;
+        while(j < restart && niter < maxIters){
+            occa::memory o_zj = flexible ? col(o_Z,j):o_z;
+            occa::memory o_w = col(o_V,j+1);
+
+            // w = J*M^(-1)*V(:,j)
+            precondition(col(o_V,j),o_zj);
+            krylovSet((size_t) N,0.0,o_w);
+            solver.residual(o_zj,o_w);
+
+            orthogonalize(j+1,o_w,h);
+            if(h[j+1] > 0.0) krylovScale(N,1.0/h[j+1],o_w,o_w);
+
+            // apply previous Givens rotations to the new column
+            for(int i = 0; i < j; ++i){
+                const double t = cs[i]*h[i] + sn[i]*h[i+1];
+                h[i+1] = -sn[i]*h[i] + cs[i]*h[i+1];
+                h[i] = t;
+            }
+
+            // new rotation eliminates h(j+1)
+            const double d = sqrt(h[j]*h[j] + h[j+1]*h[j+1]);
+            cs[j] = (d > 0.0) ? h[j]/d:1.0;
+            sn[j] = (d > 0.0) ? h[j+1]/d:0.0;
+            h[j] = d;
+            for(int i = 0; i <= j; ++i) H[i + ldh*j] = h[i];
+
+            g[j+1] = -sn[j]*g[j];
+            g[j]   =  cs[j]*g[j];
+
+            ++j;
+            ++niter;
+            history.push_back(fabs(g[j]));
+
+            const bool breakdown = (h[j] == 0.0);
+            if(breakdown || fabs(g[j]) <= tolAbs || fabs(g[j]) <= tolRel*beta0) break;
+        }
+
+        /* y = H(0:j,0:j)^(-1)*g */
+        for(int i = j-1; i >= 0; --i){
+            double tot = g[i];
+            for(int l = i+1; l < j; ++l) tot -= H[i + ldh*l]*y[l];
+            y[i] = tot/H[i + ldh*i];
+        }
+        o_h.copyFrom(y.data(),j);
+
+        /* U += Z*y (flexible) or U += M^(-1)*(V*y) */
+        if(flexible){
+            krylovCombine(N,j,1.0,o_Z,o_h,Jac.o_U);
+        } else {
+            krylovSet((size_t) N,0.0,o_t);
+            krylovCombine(N,j,1.0,o_V,o_h,o_t);
+            precondition(o_t,o_z);
+            krylovAxpy(N,1.0,o_z,Jac.o_U);
+        }
+    }
+    return niter;
+}
@@ -0,0 +1,792 @@
+/**
+ * \file    LineSolver.cxx
+ * \author  akirby
+ *
+ * \brief LineSolver class implementation
+ */
+
+/* header files */
+#include "LineSolver.hxx"
+
+/* system header files */
+#include <algorithm>
+
+int LineSolver::findPrecision(const std::string &name){
+    if(name == "fp64") return PRECISION_FP64;
+    if(name == "fp32") return PRECISION_FP32;
+    if(name == "bf16") return PRECISION_BF16;
+    if(name == "fp16") return PRECISION_FP16;
+    return -1;
+}
+
+int LineSolver::parsePrecision(const std::string &name){
+    const int p = findPrecision(name);
+    if(p < 0){
+        printf("\x1B[1;31mERROR: unknown precision '%s' (fp64, fp32, bf16, fp16)\x1B[0m\n",name.c_str());
+        exit(1);
+    }
+    return p;
+}
+
+const char *LineSolver::precisionName(int precision){
+    return (precision == PRECISION_FP32) ? "fp32":
+           (precision == PRECISION_BF16) ? "bf16":
+           (precision == PRECISION_FP16) ? "fp16":"fp64";
+}
+
+size_t LineSolver::storageBytes() const {
+    return (precision == PRECISION_FP64) ? sizeof(double):
+           (precision == PRECISION_FP32) ? sizeof(float):sizeof(unsigned short);
+}
+
+occa::properties LineSolver::baseProperties(int nvar,int maxLineElem){
+    occa::properties props;
+    props["defines/NVAR"] = nvar;
+    props["defines/MAX_LINE_ELEM"] = maxLineElem;
+    props["defines/p_Nblock"] = (nvar+9-1)/9;
+    return props;
+}
+
+/* option combinations setup() cannot build ("": valid) */
+std::string LineSolver::check() const {
+    const int nvar = Jac.nvar;
+    const int plain = !(fused || nlinesBlock > 0 || crMin > 0 || schedule || precision != PRECISION_FP64);
+
+    if(precision < 0) return "unknown precision (fp64, fp32, bf16, fp16)";
+    if(gpu.mode == NATIVE_MODE){
+        if(!plain || lowmem || adjoint || nrhs > 1 || part){
+            return "native mode supports the default fp64 line path on a single rank";
+        }
+        if(nvar > NATIVE_MAX_NVAR){
+            return "native mode supports NVAR <= " + std::to_string(NATIVE_MAX_NVAR) +
+                   " (got " + std::to_string(nvar) + ")";
+        }
+        return "";
+    }
+    if(factorReuse > 0 && lowmem){
+        return "factor_reuse requires lowmem=0 (the low-memory residual is built from the factors)";
+    }
+    if(lowmem && !plain){
+        return "lowmem=1 requires fused=0, lines_per_block=0, cr_min=0, schedule=0 and precision=fp64";
+    }
+    if(adjoint && (!plain || lowmem)){
+        return "adjoint=1 requires the default line path (fp64, no fused/batched/cr/schedule/lowmem)";
+    }
+    if(nrhs > 1){
+        if(!plain || lowmem || adjoint){
+            return "nrhs>1 requires the default line path (fp64, no fused/batched/cr/schedule/lowmem/adjoint)";
+        }
+        if(nvar*nrhs > 1024){
+            return "NVAR*nrhs = " + std::to_string(nvar*nrhs) + " exceeds 1024 threads per block";
+        }
+    }
+    if(part && (fused || lowmem || adjoint || nrhs > 1)){
+        return "MPI runs require fused=0, lowmem=0, adjoint=0 and nrhs=1";
+    }
+    if((nlinesBlock > 0 || crMin > 0 || schedule) && (fused || precision != PRECISION_FP64)){
+        return "lines_per_block/cr_min/schedule require fused=0 and precision=fp64";
+    }
+    if(fused && precision != PRECISION_FP64) return "fused iteration requires precision=fp64";
+
+    /* batched bins: lines x NVAR^2 threads per block (schedule packs >= 1 line) */
+    const int nlines = schedule ? 1:(nlinesBlock > 0) ? nlinesBlock:
+                       (crMin > 0) ? std::max(1,256/(nvar*nvar)):0;
+    if(nlines*nvar*nvar > 1024){
+        return std::to_string(nlines) + " lines per block exceeds 1024 threads per block";
+    }
+    return "";
+}
+
+void LineSolver::setup(){
+    const int nvar = Jac.nvar;
+
+    const std::string err = check();
+    if(!err.empty()){
+        printf("\x1B[1;31mERROR: %s\x1B[0m\n",err.c_str());
+        exit(1);
+    }
+
+    kernelProps = baseProperties(nvar,mesh.max_line_nelem);
+    printf("p_Nblock = %d\n",(nvar+9-1)/9);
+
+    /* utility functions */
+    occa::properties vecProps = kernelProps;
+    vecProps["defines/p_blockSize"] = vecBlock;
+    copyAtoBjac = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","copyAtoBjac",vecProps);
+    copyAtoB    = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","copyAtoB",vecProps);
+    addAtoB     = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","addAtoB",vecProps);
+
+    /* native CPU engine: vector utilities stay OCCA Serial kernels */
+    if(gpu.mode == NATIVE_MODE){
+        native = 1;
+        engine = NativeEngine::create(nvar,mesh);
+        dirtyLine.assign(mesh.nline,0);
+        printf("native engine: NVAR=%d, %s, %d lines per SIMD batch\n",
+               nvar,NativeEngine::isa(),NativeEngine::lanes());
+        return;
+    }
+
+    /* NVAR-specialized block operations (BlockCodegen), generic loops otherwise */
+    occa::properties blockProps = kernelProps;
+    if(unroll){
+        BlockCodegen::define(blockProps,nvar);
+        printf("block kernels: %s (NVAR=%d)\n",BlockCodegen::specialized(nvar) ? "unrolled":"generic",nvar);
+    }
+
+    /* line factorization */
+    lineLU = unroll ? gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v5.okl","lineLU",blockProps):
+                      gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v2.okl","lineLU",kernelProps);
+
+    /* line-list factorization (pipelined upload, incremental refactorization) */
+    occa::properties listProps = blockProps;
+    listProps["defines/p_LineList"] = 1;
+    lineCopyList = gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v4.okl","lineCopy",kernelProps);
+    lineLUList   = unroll ? gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v5.okl","lineLU",listProps):
+                            gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v4.okl","lineLU",kernelProps);
+    o_dirtylines = gpu.malloc<int>(mesh.nline);
+    dirtyLine.assign(mesh.nline,0);
+
+    /* matrix solve and linear residual calculation */
+    if(unroll){
+        solveDU = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v12.okl","triblock_solveDU",blockProps);
+        lineRes = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v12.okl","triblock_lineRes",blockProps);
+    } else {
+        solveDU = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v3.okl","triblock_solveDU",kernelProps);
+        lineRes = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v3.okl","triblock_lineRes",kernelProps);
+    }
+
+    /* low-memory mode: A through lineface, [D] rebuilt from the factors */
+    if(lowmem){
+        solveDU = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v9.okl","triblock_solveDU",kernelProps);
+        lineRes = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v9.okl","triblock_lineRes",kernelProps);
+    }
+
+    /* adjoint: transposed substitutions on the same jacDLU/DinvC/A */
+    if(adjoint){
+        solveDUT = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v10.okl","triblock_solveDUT",kernelProps);
+        lineResT = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v10.okl","triblock_lineResT",kernelProps);
+    }
+
+    /* multiple right-hand sides: each block reused across all nrhs vectors */
+    if(nrhs > 1){
+        occa::properties rhsProps = kernelProps;
+        rhsProps["defines/p_Nrhs"] = nrhs;
+        solveDU = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v11.okl","triblock_solveDU",rhsProps);
+        lineRes = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v11.okl","triblock_lineRes",rhsProps);
+        printf("p_Nrhs = %d\n",nrhs);
+    }
+
+    /* domain decomposition: interior/boundary residual around the halo exchange */
+    if(part){
+        occa::properties partProps = kernelProps;
+        partProps["defines/p_Nres"] = std::max(1,256/nvar);
+        lineRes = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v8.okl","triblock_lineRes",partProps);
+        part->setupDevice(kernelProps);
+    }
+
+    /* long lines go to cyclic reduction, the rest stay on the Thomas path */
+    if(crMin > 0 && nlinesBlock == 0) nlinesBlock = std::max(1,256/(nvar*nvar));
+
+    std::vector<int> crlist;
+    std::vector<int> jacelem;
+    if(schedule){
+        /* one launch per length bin: short lines pack more lines per block */
+        for(int b = mesh.nbin-1; b >= 0; --b){
+            std::vector<int> group;
+            for(int n = mesh.binpoint[b]; n < mesh.binpoint[b+1]; ++n){
+                const int l = mesh.schedlines[n];
+                if(crMin > 0 && mesh.linesize[l] >= crMin){
+                    crlist.push_back(l);
+                } else if(mesh.linesize[l] == 1){
+                    jacelem.push_back(mesh.lines[mesh.linepoint[l]]);
+                } else {
+                    group.push_back(l);
+                }
+            }
+            if(group.empty()) continue;
+
+            const int maxlen = mesh.linesize[group[0]];
+            const int nlines = std::max(1,std::min(1024/(nvar*nvar),64/maxlen));
+            addBin(group,nlines);
+        }
+
+        /* length-1 lines and compacted residual */
+        occa::properties schedProps = kernelProps;
+        schedProps["defines/p_Nres"] = std::max(1,256/nvar);
+        jacobiLU = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v8.okl","triblock_jacobiLU",schedProps);
+        jacobiDU = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v8.okl","triblock_jacobiDU",schedProps);
+        lineRes  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v8.okl","triblock_lineRes",schedProps);
+
+        njac = jacelem.size();
+        if(njac) o_jacelem = gpu.malloc<int>(njac,jacelem.data());
+
+        printf("line schedule: %d bins, %d Jacobi lines\n",(int) binNlines.size(),njac);
+        for(size_t b = 0; b < binNlines.size(); ++b){
+            printf("  bin %d: %d blocks x %d lines\n",(int) b,binNbatch[b],binNlines[b]);
+        }
+    } else if(nlinesBlock > 0){
+        /* batched lines: several lines per block, NVAR^2 threads per line */
+        std::vector<int> thomas;
+        for(int l = 0; l < mesh.nline; ++l){
+            (crMin > 0 && mesh.linesize[l] >= crMin) ? crlist.push_back(l):thomas.push_back(l);
+        }
+
+        /* longest lines first so each block gets lines of similar length */
+        std::stable_sort(thomas.begin(),thomas.end(),
+                         [&](int a,int b){return mesh.linesize[a] > mesh.linesize[b];});
+        addBin(thomas,nlinesBlock);
+    }
+
+    /* bins are timed where they are launched; the default path has none */
+    if(gpu.prof.enabled && gpu.prof.bins && binLU.empty() && !gpu.rank){
+        printf("\x1B[1;93mWARNING: profile_bins=1 needs schedule=1 or lines_per_block>0 "
+               "(the default path factors all lines in one launch)\x1B[0m\n");
+    }
+
+    /* block cyclic reduction: one long line per block, O(log n) levels */
+    if(crMin > 0){
+        occa::properties crProps = kernelProps;
+        crProps["defines/p_Nrows"] = std::max(1,256/(nvar*nvar));
+        crFactor  = gpu.buildKernel(SOLVER_DIR "/okl/lineCR_v1.okl","cr_factor",crProps);
+        crSolveDU = gpu.buildKernel(SOLVER_DIR "/okl/lineCR_v1.okl","cr_solveDU",crProps);
+
+        /* level >= 1 coupling blocks: sum of reduced system sizes per line */
+        std::vector<int> crpoint(crlist.size());
+        ncrrow = 0;
+        for(size_t o = 0; o < crlist.size(); ++o){
+            crpoint[o] = ncrrow;
+            for(int ns = mesh.linesize[crlist[o]]; ns > 1; ){
+                ns = (ns + 1)/2;
+                ncrrow += ns;
+            }
+        }
+
+        ncr = crlist.size();
+        if(ncr){
+            const size_t nblk = (size_t) nvar*nvar;
+            o_crlist  = gpu.malloc<int>(ncr,crlist.data());
+            o_crpoint = gpu.malloc<int>(ncr,crpoint.data());
+            o_crA     = gpu.malloc<double>(nblk*ncrrow);
+            o_crC     = gpu.malloc<double>(nblk*ncrrow);
+        }
+        printf("cyclic reduction lines: %d of %d (%d level rows)\n",ncr,mesh.nline,ncrrow);
+    }
+
+    /* fused iteration: solve + U update + line-local residual in one sweep */
+    if(fused){
+        solveDU_fused  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v6.okl","triblock_solveDU_fused",kernelProps);
+        lineResOffLine = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v6.okl","triblock_lineResOffLine",kernelProps);
+    }
+
+    /* mixed precision: reduced-precision factor storage, FP64 residual */
+    if(precision != PRECISION_FP64){
+        occa::properties lpProps = kernelProps;
+        lpProps["defines/p_lowp"] = (precision == PRECISION_FP32) ? 0:
+                                    (precision == PRECISION_BF16) ? 1:2;
+
+        packBlocks = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v5.okl","triblock_packBlocks",lpProps);
+        solveDU_lp = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v5.okl","triblock_solveDU",lpProps);
+
+        const size_t nblk = (size_t) nvar*nvar;
+        const size_t nA = Jac.A.size()/nblk;
+        const size_t bytes = storageBytes();
+
+        o_lpDia   = gpu.device.malloc(nblk*mesh.nelem*bytes);
+        o_lpDinvC = gpu.device.malloc(nblk*mesh.nelem*bytes);
+        o_lpA     = gpu.device.malloc(nblk*nA*bytes);
+        o_sDia    = gpu.malloc<float>(mesh.nelem);
+        o_sDinvC  = gpu.malloc<float>(mesh.nelem);
+        o_sA      = gpu.malloc<float>(nA);
+    }
+}
+
+void LineSolver::addBin(std::vector<int> &group,int nlines){
+    if(group.empty()) return;
+
+    occa::properties batchProps = kernelProps;
+    batchProps["defines/p_Nlines"] = nlines;
+    binLU.push_back(gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v3.okl","lineLU",batchProps));
+    binSolve.push_back(gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v7.okl","triblock_solveDU",batchProps));
+
+    const int nbatch = (group.size() + nlines - 1)/nlines;
+    std::vector<int> linelist((size_t) nbatch*nlines,-1);
+    std::copy(group.begin(),group.end(),linelist.begin());
+
+    int lo = mesh.linesize[group[0]],hi = lo;
+    for(const int l: group){
+        lo = std::min(lo,mesh.linesize[l]);
+        hi = std::max(hi,mesh.linesize[l]);
+    }
+    const std::string range = "[" + std::to_string(lo) + "-" + std::to_string(hi) + "]";
+    binLUName.push_back("lineLU" + range);
+    binSolveName.push_back("solveDU" + range);
+
+    binNlines.push_back(nlines);
+    binNbatch.push_back(nbatch);
+    o_binlist.push_back(gpu.malloc<int>(linelist.size(),linelist.data()));
+}
+
+void LineSolver::factor(){
+    PROFILE_SCOPE(gpu.prof,"factor",factorBytes());
+    if(native){
+        engine->factor(Jac.o_jacD.ptr<double>(),Jac.o_jacO1.ptr<double>(),Jac.o_jacO2.ptr<double>());
+        staleUpdates = 0;
+        return;
+    }
+    {
+        PROFILE_SCOPE(gpu.prof,"copyD",0);
+        if(lowmem && Jac.o_jacD.isInitialized()){
+            /* caller-owned device blocks (Jacobian::wrapDevice) */
+            copyAtoBjac(mesh.nelem,Jac.o_jacD,Jac.o_jacDLU);
+        } else if(lowmem){
+            /* no device copy of jacD: refactor from the host blocks */
+            Jac.o_jacDLU.copyFrom(Jac.jacD.data());
+        } else {
+            copyAtoBjac(mesh.nelem,Jac.o_jacD,Jac.o_jacDLU);
+        }
+    }
+    if(nlinesBlock > 0 || schedule){
+        PROFILE_SCOPE(gpu.prof,"lineLU",0);
+        for(size_t b = 0; b < binLU.size(); ++b){
+            ProfileScope binScope(gpu.prof,gpu.prof.bins ? binLUName[b].c_str():nullptr,0.0);
+            binLU[b](mesh.nelem,mesh.nintface,binNbatch[b],
+                     mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,o_binlist[b],
+                     Jac.o_jacDLU,Jac.o_jacO1,Jac.o_jacO2,Jac.o_jacDinvC);
+        }
+        if(njac){
+            ProfileScope jacScope(gpu.prof,"jacobiLU",0.0);
+            jacobiLU(mesh.nelem,njac,o_jacelem,Jac.o_jacDLU);
+        }
+        if(ncr){
+            ProfileScope crScope(gpu.prof,"crFactor",0.0);
+            crFactor(mesh.nelem,mesh.nintface,ncr,ncrrow,
+                     mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                     o_crlist,o_crpoint,
+                     Jac.o_jacDLU,Jac.o_A,Jac.o_jacO1,Jac.o_jacO2,o_crA,o_crC);
+        }
+    } else {
+        PROFILE_SCOPE(gpu.prof,"lineLU",0);
+        lineLU(mesh.nelem,mesh.nintface,mesh.nline,
+               mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+               Jac.o_jacDLU,Jac.o_jacO1,Jac.o_jacO2,Jac.o_jacDinvC);
+    }
+
+    packFactors();
+    staleUpdates = 0;
+}
+
+/* upload the blocks in parts and factor each line as soon as the parts
+ * holding its blocks have arrived (default line path; the batched, binned
+ * and cyclic reduction factorizations need every line at once) */
+void LineSolver::factor(Transfer &xfer){
+    const size_t nblk = (size_t) Jac.nvar*Jac.nvar;
+    const size_t bytes = nblk*(mesh.nelem + 2*(size_t) mesh.nintface)*sizeof(double);
+    const int nparts = (uploadParts > 0) ? uploadParts:
+                       std::max(1,std::min(16,(int) (bytes/xfer.slotBytes)));
+
+    if(native || nlinesBlock > 0 || schedule || crMin > 0 || nparts == 1){
+        Jac.blocksToDevice(xfer,0,1);
+        xfer.finish();
+        factor();
+        return;
+    }
+    PROFILE_SCOPE(gpu.prof,"factor",factorBytes());
+
+    /* part holding element e / face f */
+    std::vector<size_t> ebound(nparts+1),fbound(nparts+1);
+    for(int p = 0; p <= nparts; ++p){
+        ebound[p] = Transfer::split(mesh.nelem,p,nparts);
+        fbound[p] = Transfer::split(mesh.nintface,p,nparts);
+    }
+    auto partOf = [](const std::vector<size_t> &bound,int n){
+        return (int) (std::upper_bound(bound.begin(),bound.end(),(size_t) n) - bound.begin()) - 1;
+    };
+
+    /* lines grouped by the last part they need */
+    std::vector<int> ready(mesh.nline);
+    std::vector<int> partpoint(nparts+1,0);
+    for(int l = 0; l < mesh.nline; ++l){
+        int p = 0;
+        for(int m = mesh.linepoint[l]; m < mesh.linepoint[l] + mesh.linesize[l]; ++m){
+            p = std::max(p,partOf(ebound,mesh.lines[m]));
+            if(m > mesh.linepoint[l]) p = std::max(p,partOf(fbound,mesh.lineface[m]));
+        }
+        ready[l] = p;
+        ++partpoint[p+1];
+    }
+    for(int p = 0; p < nparts; ++p) partpoint[p+1] += partpoint[p];
+
+    std::vector<int> linelist(mesh.nline);
+    std::vector<int> fill(partpoint.begin(),partpoint.end()-1);
+    for(int l = 0; l < mesh.nline; ++l) linelist[fill[ready[l]]++] = l;
+    xfer.upload(o_dirtylines,linelist);
+
+    /* part p+1 is in flight while the lines of part p are factored */
+    std::vector<occa::streamTag> arrived(nparts);
+    Jac.blocksToDevice(xfer,0,nparts);
+    arrived[0] = xfer.tag();
+    for(int p = 0; p < nparts; ++p){
+        if(p+1 < nparts){
+            Jac.blocksToDevice(xfer,p+1,nparts);
+            arrived[p+1] = xfer.tag();
+        }
+        xfer.wait(arrived[p]);
+
+        const int nlist = partpoint[p+1] - partpoint[p];
+        if(nlist){
+            PROFILE_SCOPE(gpu.prof,"lineLU",0);
+            occa::memory o_list = o_dirtylines + partpoint[p];
+            if(!lowmem){
+                lineCopyList(mesh.nelem,nlist,o_list,
+                             mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+                             Jac.o_jacD,Jac.o_jacDLU);
+            }
+            lineLUList(mesh.nelem,mesh.nintface,nlist,o_list,
+                       mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                       Jac.o_jacDLU,Jac.o_jacO1,Jac.o_jacO2,Jac.o_jacDinvC);
+        }
+    }
+    xfer.finish();
+
+    packFactors();
+    staleUpdates = 0;
+}
+
+void LineSolver::packFactors(){
+    /* demote the factors once; every sweep then streams the compact copies */
+    if(precision != PRECISION_FP64){
+        PROFILE_SCOPE(gpu.prof,"packFactors",0);
+        const int nA = Jac.A.size()/(Jac.nvar*Jac.nvar);
+        packBlocks(mesh.nelem,Jac.o_jacDLU,o_lpDia,o_sDia);
+        packBlocks(mesh.nelem,Jac.o_jacDinvC,o_lpDinvC,o_sDinvC);
+        packBlocks(nA,Jac.o_A,o_lpA,o_sA);
+    }
+}
+
+int LineSolver::updateJacobian(const std::vector<int> &elems,const std::vector<int> &faces){
+    /* dirty lines: a changed diagonal block or in-line face */
+    std::vector<int> packed;
+    for(const int e: elems){
+        if(mesh.elemline[e] >= 0) dirtyLine[mesh.elemline[e]] = 1;
+    }
+    for(const int f: faces){
+        for(int s = 0; s < 2; ++s){
+            const int e = mesh.fc[2*f+s];
+            const int m = mesh.elemlinepos[e];
+            if(m < 0) continue;
+            if(m > mesh.linepoint[mesh.elemline[e]] && mesh.lineface[m] == f){
+                dirtyLine[mesh.elemline[e]] = 1;
+                packed.push_back(e);
+            }
+        }
+    }
+
+    /* the residual always sees the new blocks, packed A included (the
+     * fused epilogue reads it): only the factors may go stale */
+    Jac.updateBlocks(elems,faces);
+    Jac.repackTriBlocks(mesh,packed);
+
+    /* factor reuse: sweep with the stale factors for up to factorReuse updates */
+    if(staleUpdates < factorReuse){
+        ++staleUpdates;
+        return 0;
+    }
+    return refactorDirty();
+}
+
+int LineSolver::refactorDirty(){
+    PROFILE_SCOPE(gpu.prof,"refactor",0);
+    staleUpdates = 0;
+
+    std::vector<int> linelist;
+    for(int l = 0; l < mesh.nline; ++l){
+        if(dirtyLine[l]) linelist.push_back(l);
+    }
+    std::fill(dirtyLine.begin(),dirtyLine.end(),0);
+
+    if(linelist.empty()) return 0;
+
+    /* cyclic reduction level blocks span whole lines, the native
+     * engine keeps its own batched factors: refactor everything */
+    if(ncr || native){
+        factor();
+        return mesh.nline;
+    }
+
+    const int nlist = linelist.size();
+    o_dirtylines.copyFrom(linelist.data(),nlist);
+    if(lowmem){
+        /* no device jacD: restore the dirty lines' blocks from the host */
+        std::vector<int> elems;
+        for(const int l: linelist){
+            for(int m = mesh.linepoint[l]; m < mesh.linepoint[l] + mesh.linesize[l]; ++m){
+                elems.push_back(mesh.lines[m]);
+            }
+        }
+        Jac.restoreDiag(elems);
+    } else {
+        lineCopyList(mesh.nelem,nlist,o_dirtylines,
+                     mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+                     Jac.o_jacD,Jac.o_jacDLU);
+    }
+    lineLUList(mesh.nelem,mesh.nintface,nlist,o_dirtylines,
+               mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+               Jac.o_jacDLU,Jac.o_jacO1,Jac.o_jacO2,Jac.o_jacDinvC);
+
+    packFactors();
+    return nlist;
+}
+
+void LineSolver::reset(){
+    PROFILE_SCOPE(gpu.prof,"reset",resetBytes());
+    copyAtoB(mesh.nelem*nrhs,Jac.o_rhs,Jac.o_res);
+}
+
+void LineSolver::solve(){
+    solve(Jac.o_dU,Jac.o_res);
+}
+
+void LineSolver::solve(occa::memory &o_dU,occa::memory &o_res){
+    PROFILE_SCOPE(gpu.prof,"solve",solveBytes());
+    if(native){
+        engine->solve(o_dU.ptr<double>(),o_res.ptr<double>());
+        return;
+    }
+    if(fused){
+        solveDU_fused(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+                      mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                      Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_A,
+                      Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
+                      Jac.o_rhs,Jac.o_U,o_dU,o_res);
+    } else if(nlinesBlock > 0 || schedule){
+        for(size_t b = 0; b < binSolve.size(); ++b){
+            ProfileScope binScope(gpu.prof,gpu.prof.bins ? binSolveName[b].c_str():nullptr,0.0);
+            binSolve[b](mesh.nelem,binNbatch[b],
+                        mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,o_binlist[b],
+                        Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_A,o_dU,o_res);
+        }
+        if(njac){
+            ProfileScope jacScope(gpu.prof,"jacobiDU",0.0);
+            jacobiDU(mesh.nelem,njac,o_jacelem,Jac.o_jacDLU,o_dU,o_res);
+        }
+        if(ncr){
+            ProfileScope crScope(gpu.prof,"crSolveDU",0.0);
+            crSolveDU(mesh.nelem,mesh.nintface,ncr,ncrrow,
+                      mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                      o_crlist,o_crpoint,
+                      Jac.o_jacDLU,Jac.o_A,Jac.o_jacO1,Jac.o_jacO2,o_crA,o_crC,
+                      o_dU,o_res);
+        }
+    } else if(lowmem){
+        solveDU(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+                mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_jacO1,Jac.o_jacO2,o_dU,o_res);
+    } else if(precision == PRECISION_FP64){
+        solveDU(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+                mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+                Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_A,o_dU,o_res);
+    } else {
+        solveDU_lp(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+                   mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+                   o_lpDia,o_lpDinvC,o_lpA,o_sDia,o_sDinvC,o_sA,
+                   o_dU,o_res);
+    }
+}
+
+void LineSolver::update(){
+    if(fused) return; // applied in the solve epilogue
+
+    PROFILE_SCOPE(gpu.prof,"update",updateBytes());
+    addAtoB(mesh.nelem*nrhs,Jac.o_dU,Jac.o_U);
+    copyAtoB(mesh.nelem*nrhs,Jac.o_rhs,Jac.o_res);
+}
+
+void LineSolver::residual(){
+    residual(Jac.o_U,Jac.o_res);
+}
+
+void LineSolver::residual(occa::memory &o_U,occa::memory &o_res){
+    PROFILE_SCOPE(gpu.prof,"residual",residualBytes());
+    if(native){
+        engine->residual(Jac.o_jacD.ptr<double>(),Jac.o_jacO1.ptr<double>(),Jac.o_jacO2.ptr<double>(),
+                         o_U.ptr<double>(),o_res.ptr<double>());
+        return;
+    }
+    if(fused){
+        lineResOffLine(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+                       mesh.o_epoint,mesh.o_ef,mesh.o_fc,
+                       mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                       Jac.o_jacO1,Jac.o_jacO2,
+                       o_U,o_res);
+        return;
+    }
+
+    if(part){
+        /* interior elements overlap the exchange; boundary ones need ghosts */
+        part->exchangeStart(o_U);
+        if(part->interior.size()){
+            lineRes(mesh.nelem,mesh.nintface,(int) part->interior.size(),
+                    mesh.o_epoint,mesh.o_ef,mesh.o_fc,part->o_interior,
+                    Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
+                    o_U,o_res);
+        }
+        part->exchangeFinish(o_U);
+        if(part->boundary.size()){
+            lineRes(mesh.nelem,mesh.nintface,(int) part->boundary.size(),
+                    mesh.o_epoint,mesh.o_ef,mesh.o_fc,part->o_boundary,
+                    Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
+                    o_U,o_res);
+        }
+        return;
+    }
+
+    if(schedule || nrhs > 1){
+        lineRes(mesh.nelem,mesh.nintface,mesh.nlineelem,
+                mesh.o_epoint,mesh.o_ef,mesh.o_fc,mesh.o_lines,
+                Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
+                o_U,o_res);
+        return;
+    }
+
+    if(lowmem){
+        lineRes(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+                mesh.o_epoint,mesh.o_ef,mesh.o_fc,
+                mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
+                Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_jacO1,Jac.o_jacO2,
+                o_U,o_res);
+        return;
+    }
+
+    lineRes(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+            mesh.o_epoint,mesh.o_ef,mesh.o_fc,
+            mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+            Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
+            o_U,o_res);
+}
+
+void LineSolver::solveT(occa::memory &o_dU,occa::memory &o_res){
+    PROFILE_SCOPE(gpu.prof,"solveT",solveBytes());
+    solveDUT(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+             mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+             Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_A,o_dU,o_res);
+}
+
+void LineSolver::residualT(occa::memory &o_U,occa::memory &o_res){
+    PROFILE_SCOPE(gpu.prof,"residualT",residualBytes());
+    lineResT(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
+             mesh.o_epoint,mesh.o_ef,mesh.o_fc,
+             mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
+             Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
+             o_U,o_res);
+}
+
+double LineSolver::factorBytes() const {
+    const size_t nblk = (size_t) Jac.nvar*Jac.nvar;
+
+    /* [D] -> jacDLU: device copy, or one host upload in lowmem */
+    double bytes = (lowmem ? 1:2)*Jac.jacD.size()*sizeof(double);
+
+    /* line LU: jacDLU load/store, DinvC store, in-line face blocks */
+    bytes += 2*Jac.jacDLU.size()*sizeof(double)
+           + 1*Jac.DinvC.size()*sizeof(double)
+           + 2*(double) (mesh.nlineelem - mesh.nline)*nblk*sizeof(double)
+           + 1*mesh.fc.size()*sizeof(int)
+           + 1*mesh.linesize.size()*sizeof(int)
+           + 1*mesh.linepoint.size()*sizeof(int)
+           + 1*mesh.lines.size()*sizeof(int)
+           + 1*mesh.lineface.size()*sizeof(int);
+
+    if(ncr){
+        /* reduced-level coupling blocks */
+        bytes += 2*(double) ncrrow*nblk*sizeof(double);
+    }
+
+    if(precision != PRECISION_FP64){
+        /* packFactors: fp64 factors in, storage precision copies out */
+        const double nfac = Jac.jacDLU.size() + Jac.DinvC.size() + Jac.A.size();
+        bytes += nfac*(sizeof(double) + storageBytes());
+    }
+    return bytes;
+}
+
+double LineSolver::solveBytes() const {
+    const size_t nblk = (size_t) Jac.nvar*Jac.nvar;
+    const size_t bytes = storageBytes();
+
+    /* factored blocks at storage precision (+ one float scale per 16-bit block) */
+    double blocks = (Jac.jacDLU.size() + Jac.DinvC.size() + Jac.A.size())*bytes;
+    if(bytes == sizeof(unsigned short)){
+        blocks += (Jac.jacDLU.size() + Jac.DinvC.size() + Jac.A.size())/nblk*sizeof(float);
+    }
+
+    if(ncr){
+        /* reduced-level coupling blocks */
+        blocks += 2*(double) ncrrow*nblk*sizeof(double);
+    }
+
+    if(lowmem){
+        /* A read from the face blocks through lineface/fc */
+        blocks += 1*mesh.fc.size()*sizeof(int);
+    }
+
+    if(fused){
+        /* epilogue: U load/store, B load, [D] and in-line face blocks */
+        blocks += 2*Jac.U.size()*sizeof(double)
+                + 1*Jac.rhs.size()*sizeof(double)
+                + 1*Jac.jacD.size()*sizeof(double)
+                + 1*mesh.nlineelem*nblk*sizeof(double)
+                + 1*mesh.fc.size()*sizeof(int);
+    }
+
+    return blocks
+         + 4*Jac.dU.size()*sizeof(double) // 2 loads, 2 stores
+         + 1*Jac.res.size()*sizeof(double)
+         + 1*mesh.linesize.size()*sizeof(int)
+         + 1*mesh.linepoint.size()*sizeof(int)
+         + 1*mesh.lines.size()*sizeof(int)
+         + 1*mesh.lineface.size()*sizeof(int);
+}
+
+double LineSolver::updateBytes() const {
+    if(fused) return 0.0;
+    return 5*Jac.dU.size()*sizeof(double);
+}
+
+double LineSolver::resetBytes() const {
+    return 2*Jac.dU.size()*sizeof(double);
+}
+
+double LineSolver::residualBytes() const {
+    if(fused){
+        /* cross-line faces only */
+        const size_t noff = 2*(size_t) mesh.nintface - 2*(mesh.nlineelem - mesh.nline);
+        return noff*Jac.nvar*Jac.nvar*sizeof(double)
+             + noff*Jac.nvar*sizeof(double)     // U of off-line neighbors
+             + 2*Jac.res.size()*sizeof(double)  // 1 load, 1 store
+             + mesh.epoint.size()*sizeof(int)
+             + mesh.ef.size()*sizeof(int)
+             + mesh.fc.size()*sizeof(int)
+             + mesh.linesize.size()*sizeof(int)
+             + mesh.linepoint.size()*sizeof(int)
+             + mesh.lines.size()*sizeof(int)
+             + mesh.lineface.size()*sizeof(int);
+    }
+
+    /* lowmem: [D] = L*U + A*Gamma, i.e. factors plus the in-line A blocks */
+    const double diag = lowmem ?
+        (Jac.jacDLU.size() + Jac.DinvC.size() + Jac.A.size())*sizeof(double):
+        Jac.jacD.size()*sizeof(double);
+
+    return diag
+         + Jac.jacO1.size()*sizeof(double)
+         + Jac.jacO2.size()*sizeof(double)
+         + 5*Jac.U.size()*sizeof(double)        // U: spMV w/ 5 blocks for each element
+         + 2*Jac.res.size()*sizeof(double)      // 1 load, 1 store
+         + mesh.epoint.size()*sizeof(int)
+         + mesh.ef.size()*sizeof(int)
+         + mesh.fc.size()*sizeof(int)
+         + mesh.linesize.size()*sizeof(int)
+         + mesh.linepoint.size()*sizeof(int)
+         + mesh.lines.size()*sizeof(int)
+         + mesh.lineface.size()*sizeof(int);
+}
@@ -0,0 +1,58 @@
+/**
+ * \file    MappedFile.cxx
+ * \author  akirby
+ *
+ * \brief MappedFile class implementation
+ */
+
+/* header files */
+#include "MappedFile.hxx"
+
+/* system header files */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool MappedFile::open(const std::string &fileName){
+    close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        ::close(fd);
+        return false;
+    }
+
+    /* private mapping: writes are copy-on-write and never reach the file */
+    void *addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED) return false;
+
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    base = static_cast<char *>(addr);
+    nbytes = st.st_size;
+    fname = fileName;
+    return true;
+}
+
+void MappedFile::close(){
+    if(base) munmap(base, nbytes);
+    base = nullptr;
+    nbytes = 0;
+    fname.clear();
+}
+
+void MappedFile::prefetch(const void *addr,size_t bytes) const {
+    if(!base || bytes == 0) return;
+
+    /* madvise requires a page-aligned start address */
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const char *start = static_cast<const char *>(addr);
+    const char *aligned = base + ((start - base)/page)*page;
+
+    madvise((void *) aligned, bytes + (start - aligned), MADV_WILLNEED);
+}
@@ -7,22 +7,52 @@
 
 /* header files */
 #include "Mesh.hxx"
+#include "TriBlockFile.hxx"
 
-bool Mesh::fromFile(){
+/* system header files */
+#include <algorithm>
+
+/* copy a 1-based Fortran index record and remove the base index */
+static void rebaseIndex(HostArray<int> &dst,const int *src,int base = 1){
+    const size_t n = dst.size();
+    int *d = dst.data();
+
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < n; ++i) d[i] = src[i] - base;
+}
+
+/* caller index array: viewed in place when 0-based, rebased copy otherwise */
+static void indexArray(HostArray<int> &dst,const int *src,size_t count,int base){
+    if(base == 0){
+        dst.wrap(const_cast<int*>(src),count);
+    } else {
+        dst = HostArray<int>();
+        dst.resize(count);
+        rebaseIndex(dst,src,base);
+    }
+}
+
+bool Mesh::fromFile(const std::string &fileName){
     int mesh_data[6];
 
-    /* read mesh data from file */
-    FILE *fp = fopen("gpuline.mesh.data.bin", "rb");
+    /* map mesh data file */
+    MappedFile &file = meshFile;
     printf("---------------------------------\n");
-    if(fp == nullptr){
-        printf("\x1B[1;31mERROR: could not find gpuline.mesh.data.bin\x1B[0m\n");
+    if(!file.open(fileName)){
+        printf("\x1B[1;31mERROR: could not find %s\x1B[0m\n",fileName.c_str());
         exit(1);
     } else {
-        printf("\x1B[1;92mReading gpuline.mesh.data.bin\x1B[0m\n");
+        printf("\x1B[1;92mReading %s\x1B[0m\n",fileName.c_str());
     }
 
-    size_t nread = fread(mesh_data,sizeof(mesh_data),1,fp);
-    fclose(fp);
+    /* versioned format: indices are already 0-based, view them in place */
+    if(TriBlockFile::isTriBlock(file)) return fromTriBlockFile();
+
+    if(file.size() < sizeof(mesh_data)){
+        printf("\x1B[1;31mERROR: %s is truncated\x1B[0m\n",fileName.c_str());
+        exit(1);
+    }
+    memcpy(mesh_data,file.ptr<int>(0),sizeof(mesh_data));
 
     nvar      = mesh_data[0];
     nelem     = mesh_data[1];
@@ -31,15 +61,7 @@ bool Mesh::fromFile(){
     nline     = mesh_data[4];
     nlineelem = mesh_data[5];
 
-    printf("  Mesh Statistics:\n");
-    printf("    nvar: %d\n"
-           "    nelem: %d\n"
-           "    nintface: %d\n"
-           "    eftot: %d\n"
-           "    nline: %d\n"
-           "    nlineelem: %d\n",
-            nvar,nelem,nintface,
-            eftot,nline,nlineelem);
+    printStats();
 
     /* allocate host mesh data */
     ef.resize(eftot);
@@ -58,11 +80,48 @@ bool Mesh::fromFile(){
            + lines.size()
            + lineface.size();
 
-    /* read arrays using fortran */
-    read_mesh_data_(&nvar,&nelem,&nintface,
-                    &eftot,&nline,&nlineelem,
-                    epoint.data(),ef.data(),fc.data(),lines.data(),
-                    linesize.data(),linepoint.data(),lineface.data());
+    /* check record sizes against the header */
+    const size_t expected = sizeof(mesh_data) + nbytes*sizeof(int);
+    for(int i = 0; i < 6; ++i){
+        if(mesh_data[i] < 0){
+            printf("\x1B[1;31mERROR: %s has a corrupt header\x1B[0m\n",fileName.c_str());
+            exit(1);
+        }
+    }
+    if(file.size() != expected){
+        printf("\x1B[1;31mERROR: %s size %zu does not match header (%zu bytes)\x1B[0m\n",
+               fileName.c_str(),file.size(),expected);
+        exit(1);
+    }
+
+    /* stream records: epoint, ef, fc, linesize, linepoint, lines, lineface */
+    size_t offset = sizeof(mesh_data);
+    const int *record;
+
+    record = file.ptr<int>(offset); offset += epoint.size()*sizeof(int);
+    rebaseIndex(epoint,record);
+
+    record = file.ptr<int>(offset); offset += ef.size()*sizeof(int);
+    rebaseIndex(ef,record);
+
+    record = file.ptr<int>(offset); offset += fc.size()*sizeof(int);
+    rebaseIndex(fc,record);
+
+    /* linesize is a count, not an index */
+    record = file.ptr<int>(offset); offset += linesize.size()*sizeof(int);
+    memcpy(linesize.data(),record,linesize.size()*sizeof(int));
+
+    record = file.ptr<int>(offset); offset += linepoint.size()*sizeof(int);
+    rebaseIndex(linepoint,record);
+
+    record = file.ptr<int>(offset); offset += lines.size()*sizeof(int);
+    rebaseIndex(lines,record);
+
+    record = file.ptr<int>(offset); offset += lineface.size()*sizeof(int);
+    rebaseIndex(lineface,record);
+
+    /* records are copied: release the mapping */
+    file.close();
 
     max_line_nelem = 0;
     for(auto i: linesize) max_line_nelem = std::max(max_line_nelem,i);
@@ -72,7 +131,263 @@ bool Mesh::fromFile(){
     return true;
 }
 
+/* caller-owned arrays (library API), same records as the mesh file;
+ * base: first index (1: Fortran) */
+void Mesh::fromArrays(int _nelem,int _nintface,int _eftot,
+                      const int *_epoint,const int *_ef,const int *_fc,
+                      int _nline,int _nlineelem,const int *_linesize,const int *_linepoint,
+                      const int *_lines,const int *_lineface,int base){
+    nvar      = 0;
+    nelem     = _nelem;
+    nintface  = _nintface;
+    eftot     = _eftot;
+    nline     = _nline;
+    nlineelem = _nlineelem;
+
+    indexArray(epoint,_epoint,nelem+1,base);
+    indexArray(ef,_ef,eftot,base);
+    indexArray(fc,_fc,2*(size_t) nintface,base);
+    indexArray(linepoint,_linepoint,nline+1,base);
+    indexArray(lines,_lines,nlineelem,base);
+    indexArray(lineface,_lineface,nlineelem,base);
+
+    /* linesize is a count, not an index: copied along with rebased records */
+    indexArray(linesize,_linesize,nline,0);
+    if(base) linesize.resize(nline);
+
+    nbytes = epoint.size()
+           + ef.size()
+           + fc.size()
+           + linesize.size()
+           + linepoint.size()
+           + lines.size()
+           + lineface.size();
+
+    max_line_nelem = 0;
+    for(auto i: linesize) max_line_nelem = std::max(max_line_nelem,i);
+}
+
+bool Mesh::fromTriBlockFile(){
+    TriBlockFile tbk;
+    if(!tbk.read(meshFile,TRIBLOCK_SECTIONS_MESH)) exit(1);
+
+    nvar      = tbk.header.nvar;
+    nelem     = tbk.header.nelem;
+    nintface  = tbk.header.nintface;
+    eftot     = tbk.header.eftot;
+    nline     = tbk.header.nline;
+    nlineelem = tbk.header.nlineelem;
+    max_line_nelem = tbk.header.max_line_nelem;
+    printf("  Format: TriBlock v%d%s\n",tbk.header.version,
+           (tbk.header.flags & TRIBLOCK_FLAG_LINE_ORDER) ? " (line-ordered)":"");
+    printStats();
+
+    tbk.wrap(epoint,meshFile,SEC_EPOINT);
+    tbk.wrap(ef,meshFile,SEC_EF);
+    tbk.wrap(fc,meshFile,SEC_FC);
+    tbk.wrap(linesize,meshFile,SEC_LINESIZE);
+    tbk.wrap(linepoint,meshFile,SEC_LINEPOINT);
+    tbk.wrap(lines,meshFile,SEC_LINES);
+    tbk.wrap(lineface,meshFile,SEC_LINEFACE);
+    if(tbk.has(SEC_ELEMPERM)) tbk.wrap(elemperm,meshFile,SEC_ELEMPERM);
+
+    nbytes = epoint.size()
+           + ef.size()
+           + fc.size()
+           + linesize.size()
+           + linepoint.size()
+           + lines.size()
+           + lineface.size();
+
+    printf("  Max Line Element count: %d\n",max_line_nelem);
+    printf("Read Mesh Data Complete!\n");
+    printf("---------------------------------\n");
+    return true;
+}
+
+void Mesh::printStats(){
+    printf("  Mesh Statistics:\n");
+    printf("    nvar: %d\n"
+           "    nelem: %d\n"
+           "    nintface: %d\n"
+           "    eftot: %d\n"
+           "    nline: %d\n"
+           "    nlineelem: %d\n",
+            nvar,nelem,nintface,
+            eftot,nline,nlineelem);
+}
+
+void Mesh::buildSchedule(){
+    nbin = 1;
+    while((1 << nbin) <= max_line_nelem) ++nbin;
+
+    /* counting sort of lines into power-of-two length bins */
+    std::vector<int> bin(nline);
+    binpoint.assign(nbin+1,0);
+    for(int l = 0; l < nline; ++l){
+        int b = 0;
+        while((2 << b) <= linesize[l]) ++b;
+        bin[l] = b;
+        binpoint[b+1]++;
+    }
+    for(int b = 0; b < nbin; ++b) binpoint[b+1] += binpoint[b];
+
+    std::vector<int> fill(binpoint.begin(),binpoint.end()-1);
+    schedlines.resize(nline);
+    for(int l = 0; l < nline; ++l) schedlines[fill[bin[l]]++] = l;
+
+    binmaxlen.assign(nbin,0);
+    for(int b = 0; b < nbin; ++b){
+        std::stable_sort(schedlines.begin()+binpoint[b],schedlines.begin()+binpoint[b+1],
+                         [&](int a,int c){return linesize[a] > linesize[c];});
+        if(binpoint[b+1] > binpoint[b]) binmaxlen[b] = linesize[schedlines[binpoint[b]]];
+    }
+}
+
+void Mesh::buildElemLines(){
+    elemline.assign(nelem,-1);
+    elemlinepos.assign(nelem,-1);
+    for(int l = 0; l < nline; ++l){
+        for(int m = linepoint[l]; m < linepoint[l] + linesize[l]; ++m){
+            elemline[lines[m]] = l;
+            elemlinepos[lines[m]] = m;
+        }
+    }
+}
+
+/* replace (possibly file-backed) storage with computed data */
+static void assign(HostArray<int> &dst,const std::vector<int> &src){
+    dst = HostArray<int>();
+    dst.resize(src.size());
+    std::copy(src.begin(),src.end(),dst.begin());
+}
+
+/* Renumber elements into line order: line l, element k is stored at
+ * slot base(g) + k*W + w for line w of group g (W lines per group,
+ * longest first), so the k-th blocks of W adjacent lines are contiguous.
+ * W = 1 is plain line order; padding slots belong to no line or face. */
+void Mesh::reorderLines(int W){
+    if(W <= 0) return;
+    interleave = W;
+    nelem_native = nelem;
+
+    /* line order: longest first so interleaved groups pad little */
+    std::vector<int> order(nline);
+    for(int l = 0; l < nline; ++l) order[l] = l;
+    if(W > 1){
+        std::stable_sort(order.begin(),order.end(),
+                         [&](int a,int b){return linesize[a] > linesize[b];});
+    }
+
+    std::vector<int> nlinesize(nline);
+    std::vector<int> nlinepoint(nline+1,0);
+    std::vector<int> nlines(nlineelem);
+    std::vector<int> nlineface(nlineelem);
+    for(int l = 0; l < nline; ++l){
+        nlinesize[l] = linesize[order[l]];
+        nlinepoint[l+1] = nlinepoint[l] + nlinesize[l];
+        for(int k = 0; k < nlinesize[l]; ++k){
+            nlines[nlinepoint[l]+k] = lines[linepoint[order[l]]+k];
+            nlineface[nlinepoint[l]+k] = lineface[linepoint[order[l]]+k];
+        }
+    }
+
+    /* element <-> slot maps */
+    elemslot.assign(nelem,-1);
+    slotelem.clear();
+    for(int l0 = 0; l0 < nline; l0 += W){
+        const int nl = std::min(W,nline-l0);
+        int maxlen = 0;
+        for(int w = 0; w < nl; ++w) maxlen = std::max(maxlen,nlinesize[l0+w]);
+
+        const int base = slotelem.size();
+        slotelem.resize(base + (size_t) maxlen*W,-1);
+        for(int w = 0; w < nl; ++w){
+            for(int k = 0; k < nlinesize[l0+w]; ++k){
+                const int e = nlines[nlinepoint[l0+w]+k];
+                const int slot = base + k*W + w;
+                slotelem[slot] = e;
+                elemslot[e] = slot;
+            }
+        }
+    }
+    for(int e = 0; e < nelem; ++e){
+        if(elemslot[e] < 0){
+            elemslot[e] = slotelem.size();
+            slotelem.push_back(e);
+        }
+    }
+    const int nslot = slotelem.size();
+
+    /* renumber connectivity */
+    std::vector<int> nepoint(nslot+1,0);
+    std::vector<int> nef;
+    nef.reserve(eftot);
+    for(int s = 0; s < nslot; ++s){
+        const int e = slotelem[s];
+        if(e >= 0) nef.insert(nef.end(),ef.begin()+epoint[e],ef.begin()+epoint[e+1]);
+        nepoint[s+1] = nef.size();
+    }
+
+    std::vector<int> nfc(fc.size());
+    for(size_t n = 0; n < fc.size(); ++n) nfc[n] = elemslot[fc[n]];
+    for(auto &e: nlines) e = elemslot[e];
+
+    assign(epoint,nepoint);
+    assign(ef,nef);
+    assign(fc,nfc);
+    assign(linesize,nlinesize);
+    assign(linepoint,nlinepoint);
+    assign(lines,nlines);
+    assign(lineface,nlineface);
+
+    nbytes = epoint.size()
+           + ef.size()
+           + fc.size()
+           + linesize.size()
+           + linepoint.size()
+           + lines.size()
+           + lineface.size();
+
+    printf("Line-ordered layout: interleave %d, %d slots for %d elements (%.1f%% padding)\n",
+           W,nslot,nelem,100.0*(nslot-nelem)/nslot);
+    nelem = nslot;
+}
+
+/* slot-ordered vector -> native element order */
+void Mesh::toNative(int nvar,const double *slotvec,double *nativevec) const {
+    if(!interleave){
+        std::copy(slotvec,slotvec + (size_t) nvar*nelem,nativevec);
+        return;
+    }
+    #pragma omp parallel for schedule(static)
+    for(int e = 0; e < nelem_native; ++e){
+        std::copy(slotvec + (size_t) nvar*elemslot[e],
+                  slotvec + (size_t) nvar*(elemslot[e]+1),
+                  nativevec + (size_t) nvar*e);
+    }
+}
+
+/* native element order -> slot-ordered vector (padding slots zeroed) */
+void Mesh::fromNative(int nvar,const double *nativevec,double *slotvec) const {
+    if(!interleave){
+        std::copy(nativevec,nativevec + (size_t) nvar*nelem,slotvec);
+        return;
+    }
+    #pragma omp parallel for schedule(static)
+    for(int s = 0; s < nelem; ++s){
+        const int e = slotelem[s];
+        for(int i = 0; i < nvar; ++i){
+            slotvec[(size_t) nvar*s+i] = (e >= 0) ? nativevec[(size_t) nvar*e+i]:0.0;
+        }
+    }
+}
+
 void Mesh::setupDevice(Platform &gpu){
+    /* build line schedule */
+    buildSchedule();
+    buildElemLines();
+
     /* allocate device memory */
     o_epoint = gpu.malloc<int>(epoint.size());
     o_ef = gpu.malloc<int>(ef.size());
@@ -93,6 +408,17 @@ void Mesh::toDevice(){
     o_linepoint.copyFrom(linepoint.data());
 }
 
+/* queued on the transfer stream: wait on xfer.tag() before reading */
+void Mesh::toDevice(Transfer &xfer){
+    xfer.upload(o_epoint,epoint,meshFile);
+    xfer.upload(o_ef,ef,meshFile);
+    xfer.upload(o_fc,fc,meshFile);
+    xfer.upload(o_lines,lines,meshFile);
+    xfer.upload(o_linesize,linesize,meshFile);
+    xfer.upload(o_lineface,lineface,meshFile);
+    xfer.upload(o_linepoint,linepoint,meshFile);
+}
+
 void Mesh::fromDevice(){
     o_epoint.copyTo(epoint.data());
     o_ef.copyTo(ef.data());
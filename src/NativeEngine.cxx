@@ -0,0 +1,31 @@
+/**
+ * \file    NativeEngine.cxx
+ * \author  akirby
+ *
+ * \brief NativeEngine factory: one compiled engine per block size
+ */
+
+/* header files */
+#include "NativeEngine.hxx"
+
+#define NATIVE_CASE(n) case n: return new NativeLines<n,NATIVE_LANES>(mesh);
+
+NativeEngine *NativeEngine::create(int nvar,const Mesh &mesh){
+    switch(nvar){
+        NATIVE_CASE(1)  NATIVE_CASE(2)  NATIVE_CASE(3)  NATIVE_CASE(4)
+        NATIVE_CASE(5)  NATIVE_CASE(6)  NATIVE_CASE(7)  NATIVE_CASE(8)
+        NATIVE_CASE(9)  NATIVE_CASE(10) NATIVE_CASE(11) NATIVE_CASE(12)
+        NATIVE_CASE(13) NATIVE_CASE(14) NATIVE_CASE(15) NATIVE_CASE(16)
+    }
+
+    printf("\x1B[1;31mERROR: native mode supports NVAR <= %d (got %d)\x1B[0m\n",NATIVE_MAX_NVAR,nvar);
+    exit(1);
+}
+
+const char *NativeEngine::isa(){
+    return NATIVE_ISA;
+}
+
+int NativeEngine::lanes(){
+    return NATIVE_LANES;
+}
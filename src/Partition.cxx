@@ -0,0 +1,304 @@
+/**
+ * \file    Partition.cxx
+ * \author  akirby
+ *
+ * \brief Partition class implementation
+ */
+
+/* header files */
+#include "Partition.hxx"
+
+/* system header files */
+#include <algorithm>
+
+/* replace (possibly file-backed) storage with computed data */
+template <class T>
+static void assign(HostArray<T> &dst,const std::vector<T> &src){
+    dst = HostArray<T>();
+    dst.resize(src.size());
+    std::copy(src.begin(),src.end(),dst.begin());
+}
+
+void Partition::decompose(Mesh &mesh,Jacobian &Jac){
+    const int rank = gpu.rank;
+    const int nrank = gpu.nrank;
+    const size_t nblk = (size_t) Jac.nvar*Jac.nvar;
+
+    nvar = Jac.nvar;
+    nelem_global = mesh.nelem;
+    nline_global = mesh.nline;
+
+    /* ========================================================== */
+    /* 1. whole lines to ranks: contiguous ranges of line ids,    */
+    /*    split where the cumulative element count crosses k/nrank */
+    /* ========================================================== */
+    owner.assign(mesh.nelem,-1);
+    std::vector<int> lineowner(mesh.nline);
+    long long count = 0;
+    for(int l = 0; l < mesh.nline; ++l){
+        const long long mid = count + mesh.linesize[l]/2;
+        lineowner[l] = std::min(nrank-1,(int) (mid*nrank/std::max(1,mesh.nlineelem)));
+        count += mesh.linesize[l];
+
+        for(int m = mesh.linepoint[l]; m < mesh.linepoint[l] + mesh.linesize[l]; ++m){
+            owner[mesh.lines[m]] = lineowner[l];
+        }
+    }
+
+    /* elements on no line: block distribution by id */
+    for(int e = 0; e < mesh.nelem; ++e){
+        if(owner[e] < 0) owner[e] = (int) ((long long) e*nrank/mesh.nelem);
+    }
+
+    /* ========================================================== */
+    /* 2. local numbering: owned line elements in line order, the */
+    /*    other owned elements, then ghosts grouped by owner      */
+    /* ========================================================== */
+    std::vector<int> g2l(mesh.nelem,-1);
+    std::vector<int> lines_l,linesize_l,linepoint_l(1,0),lineface_l;
+    for(int l = 0; l < mesh.nline; ++l){
+        if(lineowner[l] != rank) continue;
+        for(int m = mesh.linepoint[l]; m < mesh.linepoint[l] + mesh.linesize[l]; ++m){
+            g2l[mesh.lines[m]] = localelem.size();
+            localelem.push_back(mesh.lines[m]);
+        }
+    }
+    const int nlineown = localelem.size();
+    for(int e = 0; e < mesh.nelem; ++e){
+        if(owner[e] == rank && g2l[e] < 0){
+            g2l[e] = localelem.size();
+            localelem.push_back(e);
+        }
+    }
+    nown = localelem.size();
+
+    /* faces touching an owned element; foreign neighbors become ghosts */
+    std::vector<int> g2lf(mesh.nintface,-1);
+    std::vector<std::pair<int,int>> ghosts; // (owner, global id)
+    for(int f = 0; f < mesh.nintface; ++f){
+        const int e1 = mesh.fc[2*f+0];
+        const int e2 = mesh.fc[2*f+1];
+        const bool own1 = (owner[e1] == rank);
+        const bool own2 = (owner[e2] == rank);
+        if(!own1 && !own2) continue;
+
+        g2lf[f] = localface.size();
+        localface.push_back(f);
+        if(!own1) ghosts.push_back({owner[e1],e1});
+        if(!own2) ghosts.push_back({owner[e2],e2});
+    }
+    std::sort(ghosts.begin(),ghosts.end());
+    ghosts.erase(std::unique(ghosts.begin(),ghosts.end()),ghosts.end());
+
+    std::vector<int> nbrIndex(nrank,-1);
+    for(const auto &g: ghosts){
+        if(nbrIndex[g.first] < 0){
+            nbrIndex[g.first] = nbr.size();
+            nbr.push_back(g.first);
+            recvpoint.push_back(localelem.size() - nown);
+        }
+        g2l[g.second] = localelem.size();
+        localelem.push_back(g.second);
+    }
+    nghost = localelem.size() - nown;
+    recvpoint.push_back(nghost);
+
+    /* send lists mirror the neighbor's ghost order (global id) */
+    std::vector<std::vector<int>> sendsets(nbr.size());
+    for(const int f: localface){
+        const int e1 = mesh.fc[2*f+0];
+        const int e2 = mesh.fc[2*f+1];
+        if(owner[e1] != rank) sendsets[nbrIndex[owner[e1]]].push_back(e2);
+        if(owner[e2] != rank) sendsets[nbrIndex[owner[e2]]].push_back(e1);
+    }
+    sendpoint.assign(1,0);
+    for(auto &s: sendsets){
+        std::sort(s.begin(),s.end());
+        s.erase(std::unique(s.begin(),s.end()),s.end());
+        for(const int e: s) sendlist.push_back(g2l[e]);
+        sendpoint.push_back(sendlist.size());
+    }
+
+    /* ========================================================== */
+    /* 3. restrict the mesh to local ids                          */
+    /* ========================================================== */
+    const int nloc = localelem.size();
+    const int nfloc = localface.size();
+
+    std::vector<int> epoint_l(nloc+1,0),ef_l,fc_l(2*nfloc);
+    for(int n = 0; n < nloc; ++n){
+        if(n < nown){
+            const int e = localelem[n];
+            for(int k = mesh.epoint[e]; k < mesh.epoint[e+1]; ++k){
+                const int f = mesh.ef[k];
+                ef_l.push_back((f >= 0) ? g2lf[f]:f);
+            }
+        }
+        epoint_l[n+1] = ef_l.size();
+    }
+    for(int n = 0; n < nfloc; ++n){
+        fc_l[2*n+0] = g2l[mesh.fc[2*localface[n]+0]];
+        fc_l[2*n+1] = g2l[mesh.fc[2*localface[n]+1]];
+    }
+    for(int l = 0; l < mesh.nline; ++l){
+        if(lineowner[l] != rank) continue;
+        for(int m = mesh.linepoint[l]; m < mesh.linepoint[l] + mesh.linesize[l]; ++m){
+            const int f = mesh.lineface[m];
+            lines_l.push_back(g2l[mesh.lines[m]]);
+            lineface_l.push_back((f >= 0) ? g2lf[f]:f);
+        }
+        linesize_l.push_back(mesh.linesize[l]);
+        linepoint_l.push_back(lines_l.size());
+    }
+
+    /* residual phases */
+    for(int n = 0; n < nlineown; ++n){
+        bool ghost = false;
+        for(int k = epoint_l[n]; k < epoint_l[n+1]; ++k){
+            const int f = ef_l[k];
+            if(f >= 0 && (fc_l[2*f] >= nown || fc_l[2*f+1] >= nown)) ghost = true;
+        }
+        ghost ? boundary.push_back(n):interior.push_back(n);
+    }
+
+    mesh.nelem     = nloc;
+    mesh.nintface  = nfloc;
+    mesh.eftot     = ef_l.size();
+    mesh.nline     = linesize_l.size();
+    mesh.nlineelem = lines_l.size();
+    assign(mesh.epoint,epoint_l);
+    assign(mesh.ef,ef_l);
+    assign(mesh.fc,fc_l);
+    assign(mesh.lines,lines_l);
+    assign(mesh.linesize,linesize_l);
+    assign(mesh.linepoint,linepoint_l);
+    assign(mesh.lineface,lineface_l);
+    mesh.nbytes = mesh.epoint.size()
+                + mesh.ef.size()
+                + mesh.fc.size()
+                + mesh.linesize.size()
+                + mesh.linepoint.size()
+                + mesh.lines.size()
+                + mesh.lineface.size();
+
+    /* ========================================================== */
+    /* 4. restrict the Jacobian: ghosts get identity diagonals    */
+    /* ========================================================== */
+    std::vector<double> jacD_l(nblk*nloc,0.0);
+    std::vector<double> A_l(nblk*nloc,0.0);
+    std::vector<double> jacO1_l(nblk*nfloc);
+    std::vector<double> jacO2_l(nblk*nfloc);
+    std::vector<double> rhs_l((size_t) nvar*nloc,0.0);
+    std::vector<double> U0_l((size_t) nvar*nloc,0.0);
+
+    #pragma omp parallel for schedule(static)
+    for(int n = 0; n < nloc; ++n){
+        const size_t e = localelem[n];
+        if(n >= nown){
+            for(int i = 0; i < nvar; ++i) jacD_l[nblk*n + nvar*i + i] = 1.0;
+            continue;
+        }
+        std::copy(&Jac.jacD[nblk*e],&Jac.jacD[nblk*(e+1)],&jacD_l[nblk*n]);
+        if(nblk*(e+1) <= Jac.A.size()) std::copy(&Jac.A[nblk*e],&Jac.A[nblk*(e+1)],&A_l[nblk*n]);
+        std::copy(&Jac.rhs[nvar*e],&Jac.rhs[nvar*(e+1)],&rhs_l[(size_t) nvar*n]);
+        std::copy(&Jac.U0[nvar*e],&Jac.U0[nvar*(e+1)],&U0_l[(size_t) nvar*n]);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(int n = 0; n < nfloc; ++n){
+        const size_t f = localface[n];
+        std::copy(&Jac.jacO1[nblk*f],&Jac.jacO1[nblk*(f+1)],&jacO1_l[nblk*n]);
+        std::copy(&Jac.jacO2[nblk*f],&Jac.jacO2[nblk*(f+1)],&jacO2_l[nblk*n]);
+    }
+
+    Jac.nelem    = nloc;
+    Jac.nintface = nfloc;
+    assign(Jac.jacD,jacD_l);
+    assign(Jac.A,A_l);
+    assign(Jac.jacO1,jacO1_l);
+    assign(Jac.jacO2,jacO2_l);
+    assign(Jac.rhs,rhs_l);
+    assign(Jac.U0,U0_l);
+
+    Jac.jacDLU.assign(nblk*nloc,0.0);
+    Jac.DinvC.assign(nblk*nloc,0.0);
+    Jac.U.assign((size_t) nvar*nloc,0.0);
+    Jac.dU.assign((size_t) nvar*nloc,0.0);
+    Jac.res.assign((size_t) nvar*nloc,0.0);
+    Jac.nbytes = Jac.jacD.size()
+               + Jac.jacO1.size()
+               + Jac.jacO2.size()
+               + Jac.rhs.size()
+               + Jac.U0.size()
+               + Jac.U.size()
+               + Jac.dU.size()
+               + Jac.res.size();
+}
+
+void Partition::setupDevice(const occa::properties &kernelProps){
+    haloPack = gpu.buildKernel(SOLVER_DIR "/okl/halo_v1.okl","haloPack",kernelProps);
+
+    const int nsend = sendlist.size();
+    if(nsend){
+        o_sendlist = gpu.malloc<int>(nsend,sendlist.data());
+        o_sendbuf  = gpu.malloc<double>((size_t) nvar*nsend);
+    }
+    if(interior.size()) o_interior = gpu.malloc<int>(interior.size(),interior.data());
+    if(boundary.size()) o_boundary = gpu.malloc<int>(boundary.size(),boundary.data());
+
+    /* pinned staging buffers for the MPI messages */
+    h_send = (double *) gpu.hostMalloc(std::max(1,nvar*nsend)*sizeof(double),nullptr,h_sendmem);
+    h_recv = (double *) gpu.hostMalloc(std::max(1,nvar*nghost)*sizeof(double),nullptr,h_recvmem);
+    requests.resize(2*nbr.size());
+    recvTag = gpu.device.tagStream();
+}
+
+void Partition::exchangeStart(occa::memory &o_U){
+    const int nsend = sendlist.size();
+    if(nsend){
+        haloPack(nsend,o_sendlist,o_U,o_sendbuf);
+        o_sendbuf.copyTo(h_send,(size_t) nvar*nsend,0,occa::properties("{async: true}"));
+    }
+    sendTag = gpu.device.tagStream();
+
+    /* h_recv is free once the previous ghost upload has finished */
+    gpu.device.waitFor(recvTag);
+    for(size_t n = 0; n < nbr.size(); ++n){
+        MPI_Irecv(h_recv + (size_t) nvar*recvpoint[n],nvar*(recvpoint[n+1] - recvpoint[n]),
+                  MPI_DOUBLE,nbr[n],0,gpu.comm,&requests[n]);
+    }
+}
+
+void Partition::exchangeFinish(occa::memory &o_U){
+    /* packed values are on the host; the interior residual keeps running */
+    PROFILE_LANE(gpu.prof,"haloWait",(double) sizeof(double)*nvar*(sendlist.size() + nghost),PROFILE_HOST);
+    gpu.device.waitFor(sendTag);
+    for(size_t n = 0; n < nbr.size(); ++n){
+        MPI_Isend(h_send + (size_t) nvar*sendpoint[n],nvar*(sendpoint[n+1] - sendpoint[n]),
+                  MPI_DOUBLE,nbr[n],0,gpu.comm,&requests[nbr.size() + n]);
+    }
+    MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+
+    /* ghosts are contiguous after the owned elements */
+    if(nghost){
+        o_U.copyFrom(h_recv,(size_t) nvar*nghost,(size_t) nvar*nown,occa::properties("{async: true}"));
+    }
+    recvTag = gpu.device.tagStream();
+}
+
+void Partition::printStats() const {
+    int local[4] = {nown,nghost,(int) boundary.size(),(int) nbr.size()};
+    int lmin[4],lmax[4],lsum[4];
+    MPI_Reduce(local,lmin,4,MPI_INT,MPI_MIN,0,gpu.comm);
+    MPI_Reduce(local,lmax,4,MPI_INT,MPI_MAX,0,gpu.comm);
+    MPI_Reduce(local,lsum,4,MPI_INT,MPI_SUM,0,gpu.comm);
+
+    if(gpu.rank) return;
+    printf("Partition: %d ranks, %d elements, %d lines (lines kept whole)\n",
+           gpu.nrank,nelem_global,nline_global);
+    printf("  owned elements per rank: min %d max %d (imbalance %.3f)\n",
+           lmin[0],lmax[0],lmax[0]/(lsum[0]/(double) gpu.nrank));
+    printf("  ghost elements per rank: min %d max %d (total %d)\n",lmin[1],lmax[1],lsum[1]);
+    printf("  boundary line elements:  min %d max %d\n",lmin[2],lmax[2]);
+    printf("  neighbor ranks:          max %d\n",lmax[3]);
+}
@@ -70,9 +70,16 @@ void Platform::DeviceConfig(int thread_model,int device_id=0,int plat=0){
     }
 
     device.setup(mode);
+    deviceSetup = mode;
 
-    char pwd[256];
-    char *ret = getcwd(pwd, 256);
-    std::string occaCacheDir = std::string(pwd) + "/.occa";
-    occa::env::setOccaCacheDir(occaCacheDir);
+    /* OCCA_CACHE_DIR selects a deployed (AOT) kernel cache */
+    const char *cacheEnv = getenv("OCCA_CACHE_DIR");
+    if(cacheEnv){
+        occa::env::setOccaCacheDir(cacheEnv);
+    } else {
+        char pwd[256];
+        char *ret = getcwd(pwd, 256);
+        std::string occaCacheDir = std::string(pwd) + "/.occa";
+        occa::env::setOccaCacheDir(occaCacheDir);
+    }
 }
@@ -0,0 +1,353 @@
+/**
+ * \file    Profiler.cxx
+ * \author  akirby
+ *
+ * \brief Profiler class implementation
+ */
+
+/* header files */
+#include "Profiler.hxx"
+
+/* system header files */
+#include <algorithm>
+#include <cerrno>
+#include <float.h>
+#include <fstream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* resolve stream tags once this many scopes are pending */
+#define PROFILE_FLUSH 4096
+
+static const char *laneName[PROFILE_LANES] = {"compute stream","transfer stream","host"};
+static const char *counterName[PROFILE_COUNTERS] = {"cycles","instructions","cache_refs","cache_misses"};
+
+/* JSON string body: names are ours, only quotes and backslashes to escape */
+static std::string jsonString(const std::string &s){
+    std::string out;
+    for(char c: s){
+        if(c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+Profiler::Profiler():
+    enabled(0),bins(0),counters(0),comm(MPI_COMM_SELF),rank(0),cpu(0),t0(0.0),
+    ntrace(0),maxTrace(1000000)
+{
+    for(int l = 0; l < PROFILE_LANES; ++l){
+        depth[l] = 0;
+        for(int d = 0; d <= PROFILE_MAX_DEPTH; ++d) cursor[l][d] = 0.0;
+    }
+}
+
+Profiler::~Profiler(){
+    closeCounters();
+}
+
+void Profiler::attach(occa::device &_device,MPI_Comm _comm,int _cpu){
+    device = _device;
+    comm = _comm;
+    cpu = _cpu;
+    MPI_Comm_rank(comm,&rank);
+}
+
+void Profiler::enable(const Options &opts){
+    enabled = opts.getInt("profile",0);
+    if(!enabled) return;
+
+    bins = opts.getInt("profile_bins",0);
+    file = opts.getString("profile_file","triblock_trace.json");
+    maxTrace = (size_t) opts.getInt("profile_max_events",1000000);
+    if(cpu && opts.getInt("profile_counters",1)) openCounters();
+    t0 = MPI_Wtime();
+}
+
+void Profiler::openCounters(){
+#ifdef __linux__
+    const unsigned long long config[PROFILE_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES
+    };
+
+    /* a perf event counts the thread that opened it (the OpenMP pool
+     * already exists, so nothing is inherited): one set per pool thread,
+     * opened inside a parallel region and summed on read */
+    int nthread = 1;
+#ifdef _OPENMP
+    nthread = omp_get_max_threads();
+#endif
+    fd.assign((size_t) nthread*PROFILE_COUNTERS,-1);
+
+    int err = 0;
+    #pragma omp parallel num_threads(nthread)
+    {
+        int t = 0,e = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        for(int c = 0; c < PROFILE_COUNTERS && !e; ++c){
+            struct perf_event_attr attr;
+            memset(&attr,0,sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config[c];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd[t*PROFILE_COUNTERS+c] = (int) syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+            if(fd[t*PROFILE_COUNTERS+c] < 0) e = errno ? errno:EINVAL;
+        }
+        if(e){
+            #pragma omp critical
+            err = e;
+        }
+    }
+    if(err){
+        if(!rank) printf("\x1B[1;93mWARNING: hardware counters unavailable (perf_event_open: %s), "
+                         "profiling without them\x1B[0m\n",strerror(err));
+        closeCounters();
+        return;
+    }
+    counters = 1;
+#else
+    if(!rank) printf("\x1B[1;93mWARNING: hardware counters need Linux perf events, "
+                     "profiling without them\x1B[0m\n");
+#endif
+}
+
+void Profiler::closeCounters(){
+#ifdef __linux__
+    for(const int f: fd) if(f >= 0) close(f);
+#endif
+    fd.clear();
+    counters = 0;
+}
+
+/* sum over the threads' counter sets */
+void Profiler::readCounters(long long *v) const {
+    for(int c = 0; c < PROFILE_COUNTERS; ++c) v[c] = 0;
+#ifdef __linux__
+    for(size_t k = 0; k < fd.size(); ++k){
+        long long x;
+        if(read(fd[k],&x,sizeof(long long)) == sizeof(long long)) v[k % PROFILE_COUNTERS] += x;
+    }
+#endif
+}
+
+int Profiler::begin(const char *name,double bytes,int lane){
+    Event ev;
+    ev.name = name;
+    ev.lane = lane;
+    ev.depth = depth[lane]++;
+    ev.bytes = bytes;
+    ev.host = MPI_Wtime() - t0;
+    ev.hostEnd = ev.host;
+    for(int c = 0; c < PROFILE_COUNTERS; ++c) ev.count[c] = 0;
+    if(counters) readCounters(ev.count);
+    if(lane != PROFILE_HOST) ev.start = device.tagStream();
+
+    pending.push_back(ev);
+    return (int) pending.size() - 1;
+}
+
+void Profiler::end(int id){
+    Event &ev = pending[id];
+    if(ev.lane != PROFILE_HOST) ev.stop = device.tagStream();
+    ev.hostEnd = MPI_Wtime() - t0;
+    if(counters){
+        long long v[PROFILE_COUNTERS];
+        readCounters(v);
+        for(int c = 0; c < PROFILE_COUNTERS; ++c) ev.count[c] = v[c] - ev.count[c];
+    }
+    depth[ev.lane]--;
+
+    /* ids index pending: resolve only with no scope open */
+    if(pending.size() >= PROFILE_FLUSH){
+        for(int l = 0; l < PROFILE_LANES; ++l) if(depth[l]) return;
+        flush();
+    }
+}
+
+void Profiler::flush(){
+    char buf[512];
+
+    for(const Event &ev: pending){
+        /* device lanes: a scope starts when it is enqueued or when the
+         * previous scope at its level drains, whichever is later */
+        double ts,dur;
+        if(ev.lane == PROFILE_HOST){
+            ts = ev.host;
+            dur = ev.hostEnd - ev.host;
+        } else {
+            const int d = std::min(ev.depth,PROFILE_MAX_DEPTH);
+            dur = device.timeBetween(ev.start,ev.stop);
+            ts = std::max(ev.host,cursor[ev.lane][d]);
+            cursor[ev.lane][d] = ts + dur;
+            if(d < PROFILE_MAX_DEPTH) cursor[ev.lane][d+1] = ts;
+        }
+
+        Stat &s = stats[ev.name];
+        if(s.calls == 0){
+            s.total = s.bytes = 0.0;
+            s.min = DBL_MAX;
+            s.max = 0.0;
+            for(int c = 0; c < PROFILE_COUNTERS; ++c) s.count[c] = 0;
+        }
+        s.calls++;
+        s.total += dur;
+        s.min = std::min(s.min,dur);
+        s.max = std::max(s.max,dur);
+        s.bytes += ev.bytes;
+        for(int c = 0; c < PROFILE_COUNTERS; ++c) s.count[c] += ev.count[c];
+
+        if(file.empty() || ntrace >= maxTrace) continue;
+        ntrace++;
+        snprintf(buf,sizeof(buf),
+                 "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                 jsonString(ev.name).c_str(),rank,ev.lane,1e6*ts,1e6*dur);
+        trace += buf;
+        snprintf(buf,sizeof(buf),"\"bytes\":%.0f,\"GB/s\":%.3f",
+                 ev.bytes,(dur > 0.0) ? 1e-9*ev.bytes/dur:0.0);
+        trace += buf;
+        if(counters){
+            for(int c = 0; c < PROFILE_COUNTERS; ++c){
+                snprintf(buf,sizeof(buf),",\"%s\":%lld",counterName[c],ev.count[c]);
+                trace += buf;
+            }
+        }
+        trace += "}},\n";
+    }
+    pending.clear();
+}
+
+void Profiler::report(){
+    int nrank;
+    MPI_Comm_size(comm,&nrank);
+
+    /* every rank's totals to root as "name calls total" lines */
+    std::string mine;
+    char buf[512];
+    for(const auto &it: stats){
+        snprintf(buf,sizeof(buf),"%s %lld %.9e\n",it.first.c_str(),it.second.calls,it.second.total);
+        mine += buf;
+    }
+    int len = (int) mine.size();
+    std::vector<int> lens(nrank),offs(nrank+1,0);
+    MPI_Gather(&len,1,MPI_INT,lens.data(),1,MPI_INT,0,comm);
+    for(int r = 0; r < nrank; ++r) offs[r+1] = offs[r] + lens[r];
+    std::vector<char> all(rank ? 1:offs[nrank]+1);
+    MPI_Gatherv(mine.data(),len,MPI_CHAR,all.data(),lens.data(),offs.data(),MPI_CHAR,0,comm);
+    if(rank) return;
+
+    /* per name: min/avg/max rank total */
+    struct Spread {double min,sum,max; int n;};
+    std::map<std::string,Spread> spread;
+    all[offs[nrank]] = '\0';
+    for(int r = 0; r < nrank; ++r){
+        std::string text(all.data()+offs[r],lens[r]);
+        size_t p = 0;
+        while(p < text.size()){
+            size_t q = text.find('\n',p);
+            char name[256];
+            long long calls;
+            double total;
+            if(sscanf(text.substr(p,q-p).c_str(),"%255s %lld %le",name,&calls,&total) == 3){
+                auto ins = spread.insert({name,{total,0.0,total,0}});
+                Spread &s = ins.first->second;
+                s.min = std::min(s.min,total);
+                s.max = std::max(s.max,total);
+                s.sum += total;
+                s.n++;
+            }
+            p = q + 1;
+        }
+    }
+
+    printf("\x1B[1;92m---------------------------------------------------------------------------------------------\x1B[0m\n");
+    printf("\x1B[1;92mProfile (rank 0; total over ranks: min/avg/max)\x1B[0m\n");
+    printf("%-24s %8s %11s %10s %10s %10s %9s",
+           "name","calls","total [s]","avg [us]","min [us]","max [us]","GB/s");
+    if(nrank > 1) printf(" %11s %11s %11s","rank min","rank avg","rank max");
+    if(counters) printf(" %6s %8s","IPC","miss %");
+    printf("\n");
+    for(const auto &it: stats){
+        const Stat &s = it.second;
+        printf("%-24s %8lld %11.4e %10.2f %10.2f %10.2f",
+               it.first.c_str(),s.calls,s.total,1e6*s.total/s.calls,1e6*s.min,1e6*s.max);
+        (s.bytes > 0.0 && s.total > 0.0) ? printf(" %9.2f",1e-9*s.bytes/s.total):printf(" %9s","-");
+        if(nrank > 1){
+            const Spread &r = spread[it.first];
+            printf(" %11.4e %11.4e %11.4e",r.min,r.sum/r.n,r.max);
+        }
+        if(counters){
+            printf(" %6.2f %8.2f",
+                   (s.count[0] > 0) ? (double) s.count[1]/s.count[0]:0.0,
+                   (s.count[2] > 0) ? 100.0*s.count[3]/s.count[2]:0.0);
+        }
+        printf("\n");
+    }
+    printf("\x1B[1;92m---------------------------------------------------------------------------------------------\x1B[0m\n");
+}
+
+void Profiler::writeTrace(){
+    int nrank;
+    MPI_Comm_size(comm,&nrank);
+
+    /* metadata: one process per rank, one thread per lane */
+    std::string mine;
+    char buf[256];
+    snprintf(buf,sizeof(buf),"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}},\n",
+             rank,rank);
+    mine += buf;
+    for(int l = 0; l < PROFILE_LANES; ++l){
+        snprintf(buf,sizeof(buf),"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+                 rank,l,laneName[l]);
+        mine += buf;
+    }
+    mine += trace;
+
+    unsigned long long nevent = ntrace,ntotal = 0;
+    int full = (ntrace >= maxTrace),truncated = 0;
+    MPI_Reduce(&nevent,&ntotal,1,MPI_UNSIGNED_LONG_LONG,MPI_SUM,0,comm);
+    MPI_Reduce(&full,&truncated,1,MPI_INT,MPI_MAX,0,comm);
+
+    int len = (int) mine.size();
+    std::vector<int> lens(nrank),offs(nrank+1,0);
+    MPI_Gather(&len,1,MPI_INT,lens.data(),1,MPI_INT,0,comm);
+    for(int r = 0; r < nrank; ++r) offs[r+1] = offs[r] + lens[r];
+    std::vector<char> all(rank ? 1:offs[nrank]);
+    MPI_Gatherv(mine.data(),len,MPI_CHAR,all.data(),lens.data(),offs.data(),MPI_CHAR,0,comm);
+    if(rank) return;
+
+    std::ofstream out(file);
+    if(!out){
+        printf("\x1B[1;31mERROR: cannot write profile trace %s\x1B[0m\n",file.c_str());
+        return;
+    }
+
+    /* drop the last separator so the array is valid JSON */
+    size_t n = all.size();
+    while(n > 0 && (all[n-1] == '\n' || all[n-1] == ',')) n--;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out.write(all.data(),n);
+    out << "\n]}\n";
+
+    printf("\x1B[1;92mProfile trace: %s (%llu events%s)\x1B[0m\n",file.c_str(),ntotal,
+           truncated ? ", truncated by profile_max_events":"");
+}
+
+void Profiler::finish(){
+    if(!enabled) return;
+    flush();
+    report();
+    if(!file.empty()) writeTrace();
+}
@@ -0,0 +1,310 @@
+/**
+ * \file    Reference.cxx
+ * \author  akirby
+ *
+ * \brief Reference class implementation (port of linesmoothLU.f90)
+ */
+
+/* header files */
+#include "Reference.hxx"
+
+/* system header files */
+#include <algorithm>
+
+Reference::Reference(const Mesh &_mesh,const Jacobian &_Jac):
+    tol(1.0e-10),failIter(0),mesh(_mesh),Jac(_Jac),nvar(_Jac.nvar)
+{
+    if(nvar > REF_MAX_NVAR || Jac.nrhs != 1){
+        printf("\x1B[1;31mERROR: the reference smoother needs nrhs=1 and NVAR <= %d\x1B[0m\n",REF_MAX_NVAR);
+        exit(1);
+    }
+    const size_t nv = (size_t) nvar*mesh.nelem;
+    dU.assign(nv,0.0);
+    U.assign(nv,0.0);
+    R.assign(nv,0.0);
+}
+
+/* default tolerance per factor storage precision */
+double Reference::tolerance(const Options &opts){
+    if(opts.has("verify_tol")) return opts.getDouble("verify_tol",0.0);
+
+    switch(LineSolver::parsePrecision(opts.getString("precision","fp64"))){
+        case PRECISION_FP32: return 1.0e-4;
+        case PRECISION_FP16: return 1.0e-2;
+        case PRECISION_BF16: return 5.0e-2;
+    }
+    return 1.0e-10;
+}
+
+/* ====================================================================== */
+/* Dense block operations: column-major, entry (i,j) at i+n*j             */
+/* ====================================================================== */
+void Reference::LU(double *M,int n){
+    for(int k = 0; k < n; ++k){
+        const double piv = 1.0/M[k+n*k];
+        for(int i = k+1; i < n; ++i) M[i+n*k] *= piv;
+        for(int j = k+1; j < n; ++j){
+            for(int i = k+1; i < n; ++i) M[i+n*j] -= M[i+n*k]*M[k+n*j];
+        }
+    }
+}
+
+void Reference::solveLU(const double *M,const double *b,double *x,int n){
+    for(int i = 0; i < n; ++i){
+        double s = b[i];
+        for(int j = 0; j < i; ++j) s -= M[i+n*j]*x[j];
+        x[i] = s;
+    }
+    for(int i = n-1; i >= 0; --i){
+        double s = x[i];
+        for(int j = i+1; j < n; ++j) s -= M[i+n*j]*x[j];
+        x[i] = s/M[i+n*i];
+    }
+}
+
+/* y = L*(U*x) of an LU-factored block */
+void Reference::LUmatmul(const double *M,const double *x,double *y,int n){
+    double t[REF_MAX_NVAR];
+    for(int i = 0; i < n; ++i){
+        double s = 0.0;
+        for(int j = i; j < n; ++j) s += M[i+n*j]*x[j];
+        t[i] = s;
+    }
+    for(int i = 0; i < n; ++i){
+        double s = t[i];
+        for(int j = 0; j < i; ++j) s += M[i+n*j]*t[j];
+        y[i] = s;
+    }
+}
+
+void Reference::matmul(const double *M,const double *x,double *y,int n){
+    for(int i = 0; i < n; ++i){
+        double s = 0.0;
+        for(int j = 0; j < n; ++j) s += M[i+n*j]*x[j];
+        y[i] = s;
+    }
+}
+
+/* block coupling element e to the other element of face f */
+const double *Reference::offBlock(int e,int f) const {
+    const size_t nb = (size_t) nvar*nvar;
+    return (e == mesh.fc[2*f]) ? Jac.jacO2.data() + nb*f:Jac.jacO1.data() + nb*f;
+}
+
+/* ====================================================================== */
+/* Line factorization: D~_k = D_k - O_(k,k-1) D~_(k-1)^(-1) O_(k-1,k)     */
+/* ====================================================================== */
+void Reference::factor(){
+    const int n = nvar;
+    const size_t nb = (size_t) n*n;
+    Dia.assign(Jac.jacD.begin(),Jac.jacD.begin() + nb*mesh.nelem);
+
+    #pragma omp parallel for
+    for(int l = 0; l < mesh.nline; ++l){
+        double col[REF_MAX_NVAR],t[REF_MAX_NVAR];
+        const int p = mesh.linepoint[l];
+
+        LU(&Dia[nb*mesh.lines[p]],n);
+        for(int k = 1; k < mesh.linesize[l]; ++k){
+            const int e = mesh.lines[p+k];
+            const int elast = mesh.lines[p+k-1];
+            const int f = mesh.lineface[p+k];
+            const double *Oe = offBlock(e,f);
+            const double *Ol = offBlock(elast,f);
+
+            for(int j = 0; j < n; ++j){
+                solveLU(&Dia[nb*elast],Ol + n*j,t,n);
+                matmul(Oe,t,col,n);
+                for(int i = 0; i < n; ++i) Dia[nb*e+i+n*j] -= col[i];
+            }
+            LU(&Dia[nb*e],n);
+        }
+    }
+}
+
+void Reference::reset(const double *U0){
+    const size_t nv = (size_t) nvar*mesh.nelem;
+    std::copy(U0,U0 + nv,U.begin());
+    std::copy(Jac.rhs.begin(),Jac.rhs.begin() + nv,R.begin());
+    std::fill(dU.begin(),dU.end(),0.0);
+}
+
+/* ====================================================================== */
+/* One sweep: line solve for dU, U += dU, linear residual R = B + J*U     */
+/* ====================================================================== */
+void Reference::solveLine(int l){
+    const int n = nvar;
+    const size_t nb = (size_t) n*n;
+    const int p = mesh.linepoint[l];
+    double S[REF_MAX_NVAR],t[REF_MAX_NVAR];
+
+    /* forward substitution */
+    int e = mesh.lines[p];
+    for(int i = 0; i < n; ++i) S[i] = -R[n*e+i];
+    solveLU(&Dia[nb*e],S,&dU[n*e],n);
+    for(int k = 1; k < mesh.linesize[l]; ++k){
+        e = mesh.lines[p+k];
+        const int elast = mesh.lines[p+k-1];
+        matmul(offBlock(e,mesh.lineface[p+k]),&dU[n*elast],t,n);
+        for(int i = 0; i < n; ++i) S[i] = -R[n*e+i] - t[i];
+        solveLU(&Dia[nb*e],S,&dU[n*e],n);
+    }
+
+    /* backward substitution */
+    for(int k = mesh.linesize[l]-2; k >= 0; --k){
+        e = mesh.lines[p+k];
+        const int enext = mesh.lines[p+k+1];
+        matmul(offBlock(e,mesh.lineface[p+k+1]),&dU[n*enext],t,n);
+        solveLU(&Dia[nb*e],t,S,n);
+        for(int i = 0; i < n; ++i) dU[n*e+i] -= S[i];
+    }
+}
+
+void Reference::residualLine(int l){
+    const int n = nvar;
+    const size_t nb = (size_t) n*n;
+    const int p = mesh.linepoint[l];
+    double S[REF_MAX_NVAR],t[REF_MAX_NVAR],w[REF_MAX_NVAR];
+
+    for(int k = 0; k < mesh.linesize[l]; ++k){
+        const int e = mesh.lines[p+k];
+        double *r = &R[n*e];
+
+        /* D*U from the factors: D~_k U + O_(k,k-1) D~_(k-1)^(-1) O_(k-1,k) U */
+        LUmatmul(&Dia[nb*e],&U[n*e],S,n);
+        for(int i = 0; i < n; ++i) r[i] += S[i];
+        if(k > 0){
+            const int elast = mesh.lines[p+k-1];
+            const int f = mesh.lineface[p+k];
+            matmul(offBlock(elast,f),&U[n*e],t,n);
+            solveLU(&Dia[nb*elast],t,w,n);
+            matmul(offBlock(e,f),w,t,n);
+            for(int i = 0; i < n; ++i) r[i] += t[i];
+        }
+
+        /* off-diagonal blocks of every interior face */
+        for(int q = mesh.epoint[e]; q < mesh.epoint[e+1]; ++q){
+            const int f = mesh.ef[q];
+            if(f < 0) continue;
+
+            const int e1 = mesh.fc[2*f+0];
+            const int e2 = mesh.fc[2*f+1];
+            matmul(offBlock(e,f),&U[n*((e1 == e) ? e2:e1)],t,n);
+            for(int i = 0; i < n; ++i) r[i] += t[i];
+        }
+    }
+}
+
+void Reference::sweep(){
+    const int n = nvar;
+
+    #pragma omp parallel for
+    for(int l = 0; l < mesh.nline; ++l) solveLine(l);
+
+    #pragma omp parallel for
+    for(int m = 0; m < mesh.nlineelem; ++m){
+        const int e = mesh.lines[m];
+        for(int i = 0; i < n; ++i){
+            U[n*e+i] += dU[n*e+i];
+            R[n*e+i] = Jac.rhs[(size_t) n*e+i];
+        }
+    }
+
+    #pragma omp parallel for
+    for(int l = 0; l < mesh.nline; ++l) residualLine(l);
+}
+
+/* ====================================================================== */
+/* Lockstep comparison against a device solver                            */
+/* ====================================================================== */
+/* max|x - xref| over the line elements (NaN propagates) */
+double Reference::error(const std::vector<double> &x,const std::vector<double> &xref) const {
+    double diff = 0.0;
+    for(int m = 0; m < mesh.nlineelem; ++m){
+        const size_t e = mesh.lines[m];
+        for(int i = 0; i < nvar; ++i){
+            const double d = std::fabs(x[nvar*e+i] - xref[nvar*e+i]);
+            diff = (d > diff || d != d) ? d:diff;
+        }
+    }
+    return diff;
+}
+
+double Reference::maxAbs(const double *x) const {
+    double a = 0.0;
+    for(int m = 0; m < mesh.nlineelem; ++m){
+        const size_t e = mesh.lines[m];
+        for(int i = 0; i < nvar; ++i) a = std::max(a,std::fabs(x[nvar*e+i]));
+    }
+    return (a > 0.0) ? a:1.0;
+}
+
+bool Reference::verify(LineSolver &solver,const std::vector<double> &U0,int iters){
+    Jacobian &J = solver.Jac;
+    const size_t nv = (size_t) nvar*mesh.nelem;
+    std::vector<double> h_dU(nv),h_U(nv),h_res(nv);
+
+    /* a line-ordered solver on its own mesh (Mesh::reorderLines) stores
+     * slots: its vectors are mapped to the native elements compared here */
+    const Mesh *slots = (&solver.mesh != &mesh && solver.mesh.interleave) ? &solver.mesh:nullptr;
+    std::vector<double> h_slot(slots ? J.U.size():0);
+    auto fetch = [&](occa::memory &o_x,std::vector<double> &x){
+        if(!slots){
+            o_x.copyTo(x.data());
+            return;
+        }
+        o_x.copyTo(h_slot.data());
+        slots->toNative(nvar,h_slot.data(),x.data());
+    };
+
+    for(int v = 0; v < 3; ++v) err[v].clear();
+    failIter = 0;
+
+    factor();
+    reset(U0.data());
+    const double scaleB = maxAbs(Jac.rhs.data());
+
+    if(slots){
+        slots->fromNative(nvar,U0.data(),h_slot.data());
+        J.o_U.copyFrom(h_slot.data());
+    } else {
+        J.o_U.copyFrom(U0.data());
+    }
+    solver.reset();
+    for(int k = 1; k <= iters; ++k){
+        solver.solve();
+        solver.update();
+        solver.residual();
+        sweep();
+
+        fetch(J.o_dU,h_dU);
+        fetch(J.o_U,h_U);
+        fetch(J.o_res,h_res);
+
+        /* dU and res vanish as the sweeps converge: scale by the terms they cancel */
+        const double scaleU = maxAbs(U.data());
+        err[REF_DU].push_back(error(h_dU,dU)/scaleU);
+        err[REF_U].push_back(error(h_U,U)/scaleU);
+        err[REF_RES].push_back(error(h_res,R)/scaleB);
+
+        for(int v = 0; v < 3; ++v){
+            if(!failIter && !(err[v].back() <= k*tol)) failIter = k;
+        }
+    }
+    return (failIter == 0);
+}
+
+double Reference::maxError(int v) const {
+    double m = 0.0;
+    for(const double x: err[v]) m = (x > m || x != x) ? x:m;
+    return m;
+}
+
+void Reference::printHistory() const {
+    printf("  iter     err(dU)      err(U)    err(res)       limit\n");
+    for(size_t k = 0; k < err[REF_DU].size(); ++k){
+        printf("  %4d  %.4e  %.4e  %.4e  %.4e%s\n",(int) k+1,
+               err[REF_DU][k],err[REF_U][k],err[REF_RES][k],(k+1)*tol,
+               ((int) k+1 == failIter) ? "  <-- FAIL":"");
+    }
+}
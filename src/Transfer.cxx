@@ -0,0 +1,83 @@
+/**
+ * \file    Transfer.cxx
+ * \author  akirby
+ *
+ * \brief Transfer class implementation
+ */
+
+/* header files */
+#include "Transfer.hxx"
+
+/* staging offsets within a slot */
+#define TRANSFER_ALIGN 256
+
+Transfer::Transfer(Platform &_gpu,size_t _slotBytes):
+    gpu(_gpu),slotBytes(_slotBytes),cur(0)
+{
+    stream = gpu.device.createStream();
+    for(int s = 0; s < TRANSFER_SLOTS; ++s){
+        slot[s] = nullptr;
+        used[s] = 0;
+    }
+}
+
+occa::streamTag Transfer::tag(){
+    occa::stream compute = gpu.device.getStream();
+    gpu.device.setStream(stream);
+    occa::streamTag t = gpu.device.tagStream();
+    gpu.device.setStream(compute);
+    return t;
+}
+
+void Transfer::wait(const occa::streamTag &t){
+    gpu.device.waitFor(t);
+}
+
+void Transfer::finish(){
+    /* oldest first: every queued copy holds its slot until released */
+    for(int k = 1; k <= TRANSFER_SLOTS; ++k){
+        release((cur + k) % TRANSFER_SLOTS);
+    }
+}
+
+char *Transfer::acquire(size_t bytes){
+    const size_t offset = (used[cur] + TRANSFER_ALIGN - 1)/TRANSFER_ALIGN*TRANSFER_ALIGN;
+
+    /* current slot full: move on, waiting for the next one to drain */
+    if(!slot[cur] || offset + bytes > slotBytes){
+        if(slot[cur]) cur = (cur + 1) % TRANSFER_SLOTS;
+        release(cur);
+        if(!slot[cur]){
+            /* pinned on first use: small runs never pin the whole ring */
+            slot[cur] = (char *) gpu.hostMalloc(slotBytes,nullptr,h_slot[cur]);
+        }
+        used[cur] = bytes;
+        return slot[cur];
+    }
+    used[cur] = offset + bytes;
+    return slot[cur] + offset;
+}
+
+void Transfer::release(int s){
+    if(!used[s]) return;
+
+    gpu.device.waitFor(slotTag[s]);
+    for(auto &l : landing[s]){
+        memcpy(l.dst,l.src,l.bytes);
+    }
+    landing[s].clear();
+    used[s] = 0;
+}
+
+void Transfer::copy(char *buf,occa::memory &o_mem,size_t count,size_t offset,size_t bytes,bool toDevice){
+    occa::stream compute = gpu.device.getStream();
+    gpu.device.setStream(stream);
+    {
+        PROFILE_LANE(gpu.prof,toDevice ? "upload":"download",bytes,PROFILE_TRANSFER);
+        toDevice ? o_mem.copyFrom(buf,count,offset,occa::properties("{async: true}")):
+                   o_mem.copyTo(buf,count,offset,occa::properties("{async: true}"));
+    }
+    slotTag[cur] = gpu.device.tagStream();
+
+    gpu.device.setStream(compute);
+}
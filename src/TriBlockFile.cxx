@@ -0,0 +1,147 @@
+/**
+ * \file    TriBlockFile.cxx
+ * \author  akirby
+ *
+ * \brief TriBlockFile format reader/writer implementation
+ */
+
+/* header files */
+#include "TriBlockFile.hxx"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME  1099511628211ULL
+#define CHECKSUM_CHUNK (1<<20)
+
+static const char *section_name[SEC_COUNT] = {
+    "epoint","ef","fc","linesize","linepoint","lines","lineface",
+    "jacD","jacO1","jacO2","rhs","U0","A","elemperm"
+};
+
+bool TriBlockFile::isTriBlock(const MappedFile &file){
+    return file.size() >= sizeof(TriBlockHeader)
+        && memcmp(file.ptr<char>(0),TRIBLOCK_FILE_MAGIC,8) == 0;
+}
+
+/* 64-bit FNV-1a over 8-byte words of 1 MiB chunks, chunk hashes folded
+ * in order: independent of thread count, runs at memory bandwidth */
+uint64_t TriBlockFile::checksum(const void *data,size_t bytes){
+    const unsigned char *src = static_cast<const unsigned char *>(data);
+    const size_t nchunk = (bytes + CHECKSUM_CHUNK - 1)/CHECKSUM_CHUNK;
+    std::vector<uint64_t> partial(nchunk);
+
+    #pragma omp parallel for schedule(static)
+    for(size_t c = 0; c < nchunk; ++c){
+        const unsigned char *p = src + c*CHECKSUM_CHUNK;
+        const size_t n = std::min((size_t) CHECKSUM_CHUNK,bytes - c*CHECKSUM_CHUNK);
+
+        uint64_t h = FNV_OFFSET;
+        size_t i = 0;
+        for(; i + 8 <= n; i += 8){
+            uint64_t w;
+            memcpy(&w,p+i,8);
+            h = (h ^ w)*FNV_PRIME;
+        }
+        for(; i < n; ++i) h = (h ^ p[i])*FNV_PRIME;
+        partial[c] = h;
+    }
+
+    uint64_t h = FNV_OFFSET;
+    for(auto p: partial) h = (h ^ p)*FNV_PRIME;
+    return h;
+}
+
+/* header and section layout of the whole file; checksums of the
+ * sections in the verify mask (TRIBLOCK_SECTIONS_*) */
+bool TriBlockFile::read(const MappedFile &file,uint32_t verify){
+    if(!isTriBlock(file)){
+        printf("\x1B[1;31mERROR: %s is not a TriBlock file\x1B[0m\n",file.name().c_str());
+        return false;
+    }
+    memcpy(&header,file.ptr<char>(0),sizeof(header));
+
+    if(header.version < 1 || header.version > TRIBLOCK_FILE_VERSION){
+        printf("\x1B[1;31mERROR: %s has unsupported version %d (max %d)\x1B[0m\n",
+               file.name().c_str(),header.version,TRIBLOCK_FILE_VERSION);
+        return false;
+    }
+
+    const size_t nblk = (size_t) header.nvar*header.nvar;
+    size_t expected[SEC_COUNT];
+    expected[SEC_EPOINT]    = sizeof(int)*(header.nelem+1);
+    expected[SEC_EF]        = sizeof(int)*header.eftot;
+    expected[SEC_FC]        = sizeof(int)*2*header.nintface;
+    expected[SEC_LINESIZE]  = sizeof(int)*header.nline;
+    expected[SEC_LINEPOINT] = sizeof(int)*(header.nline+1);
+    expected[SEC_LINES]     = sizeof(int)*header.nlineelem;
+    expected[SEC_LINEFACE]  = sizeof(int)*header.nlineelem;
+    expected[SEC_JACD]      = sizeof(double)*nblk*header.nelem;
+    expected[SEC_JACO1]     = sizeof(double)*nblk*header.nintface;
+    expected[SEC_JACO2]     = sizeof(double)*nblk*header.nintface;
+    expected[SEC_RHS]       = sizeof(double)*header.nvar*header.nelem;
+    expected[SEC_U0]        = sizeof(double)*header.nvar*header.nelem;
+    expected[SEC_A]         = sizeof(double)*nblk*header.nlineelem;
+    expected[SEC_ELEMPERM]  = sizeof(int)*header.nelem;
+
+    for(int id = 0; id < SEC_COUNT; ++id){
+        const TriBlockSection &s = header.section[id];
+        const bool optional = (id == SEC_A) || (id == SEC_ELEMPERM);
+
+        if(s.bytes == 0 && optional) continue;
+        if(s.bytes != expected[id]
+        || s.offset % TRIBLOCK_FILE_ALIGN
+        || s.offset + s.bytes > file.size()){
+            printf("\x1B[1;31mERROR: %s section [%s] is malformed\x1B[0m\n",
+                   file.name().c_str(),section_name[id]);
+            return false;
+        }
+
+        if((verify & (1u<<id)) && checksum(file.ptr<char>(s.offset),s.bytes) != s.checksum){
+            printf("\x1B[1;31mERROR: %s section [%s] checksum mismatch\x1B[0m\n",
+                   file.name().c_str(),section_name[id]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TriBlockFile::write(const std::string &fileName,
+                         TriBlockHeader &hdr,
+                         const void *data[SEC_COUNT],
+                         const size_t bytes[SEC_COUNT]){
+    FILE *fp = fopen(fileName.c_str(),"wb");
+    if(fp == nullptr){
+        printf("\x1B[1;31mERROR: could not open %s for writing\x1B[0m\n",fileName.c_str());
+        return false;
+    }
+
+    memcpy(hdr.magic,TRIBLOCK_FILE_MAGIC,8);
+    hdr.version = TRIBLOCK_FILE_VERSION;
+    hdr.reserved = 0;
+
+    /* lay out sections on aligned boundaries */
+    uint64_t offset = sizeof(TriBlockHeader);
+    for(int id = 0; id < SEC_COUNT; ++id){
+        hdr.section[id].offset = offset;
+        hdr.section[id].bytes = data[id] ? bytes[id]:0;
+        hdr.section[id].checksum = data[id] ? checksum(data[id],bytes[id]):0;
+
+        offset += hdr.section[id].bytes;
+        offset = (offset + TRIBLOCK_FILE_ALIGN - 1)/TRIBLOCK_FILE_ALIGN*TRIBLOCK_FILE_ALIGN;
+    }
+
+    static const char pad[TRIBLOCK_FILE_ALIGN] = {0};
+    bool ok = fwrite(&hdr,sizeof(hdr),1,fp) == 1;
+    for(int id = 0; id < SEC_COUNT && ok; ++id){
+        const size_t n = hdr.section[id].bytes;
+        if(n) ok = fwrite(data[id],1,n,fp) == n;
+
+        const size_t npad = (TRIBLOCK_FILE_ALIGN - n % TRIBLOCK_FILE_ALIGN) % TRIBLOCK_FILE_ALIGN;
+        if(npad && ok) ok = fwrite(pad,1,npad,fp) == npad;
+    }
+    ok = (fclose(fp) == 0) && ok;
+
+    if(!ok){
+        printf("\x1B[1;31mERROR: failed writing %s\x1B[0m\n",fileName.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,280 @@
+/**
+ * \file    TriBlockSolver.cxx
+ * \author  akirby
+ *
+ * \brief TriBlockSolver class implementation
+ */
+
+/* header files */
+#include "TriBlockSolver.hxx"
+#include "KernelCache.hxx"
+#include "Convergence.hxx"
+
+/* MPI for callers that do not use it: initialized once, finalized at exit */
+static void finalizeMPI(){
+    int done;
+    MPI_Finalized(&done);
+    if(!done) MPI_Finalize();
+}
+
+static MPI_Comm selfComm(){
+    int init;
+    MPI_Initialized(&init);
+    if(!init){
+        MPI_Init(nullptr,nullptr);
+        atexit(finalizeMPI);
+    }
+    return MPI_COMM_SELF;
+}
+
+TriBlockSolver::TriBlockSolver(int mode,int device_id,const Options &_opts):
+    opts(_opts),gpu(selfComm(),mode,device_id),xfer(gpu),solver(nullptr),
+    location(-1),hasMesh(0),staged(0),factored(0),
+    niter(0),resNorm(0.0),status(CONV_RUNNING)
+{}
+
+int TriBlockSolver::setMesh(int nelem,int nintface,int eftot,
+                             const int *epoint,const int *ef,const int *fc,
+                             int nline,int nlineelem,const int *linesize,const int *linepoint,
+                             const int *lines,const int *lineface,int base){
+    if(hasMesh){
+        printf("\x1B[1;31mERROR: triblock mesh already set; create a new solver for a new mesh\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+    mesh.fromArrays(nelem,nintface,eftot,epoint,ef,fc,
+                    nline,nlineelem,linesize,linepoint,lines,lineface,base);
+
+    /* line_order=W: slot storage, caller vectors mapped in solve() */
+    if(opts.getInt("line_order",0) > 0) mesh.reorderLines(opts.getInt("line_order",0));
+    mesh.setupDevice(gpu);
+    mesh.toDevice(xfer);
+    hasMesh = 1;
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::prepare(int nvar){
+    if(!hasMesh){
+        printf("\x1B[1;31mERROR: set the triblock mesh before the Jacobian\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+    if(location >= 0 && nvar != Jac.nvar){
+        printf("\x1B[1;31mERROR: triblock block size changed (%d -> %d); create a new solver\x1B[0m\n",Jac.nvar,nvar);
+        return TRIBLOCK_ERROR;
+    }
+
+    /* the blocks of a previous call may still be in flight */
+    xfer.finish();
+    factored = 0;
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::setJacobian(int nvar,const double *D,const double *O1,const double *O2,
+                                const double *rhs,int where){
+    if(where == TRIBLOCK_DEVICE){
+        if(prepare(nvar)) return TRIBLOCK_ERROR;
+        if(mesh.interleave){
+            printf("\x1B[1;31mERROR: triblock line_order needs TRIBLOCK_HOST arrays\x1B[0m\n");
+            return TRIBLOCK_ERROR;
+        }
+        occa::memory o_D   = wrap(D,(size_t) nvar*nvar*mesh.nelem);
+        occa::memory o_O1  = wrap(O1,(size_t) nvar*nvar*mesh.nintface);
+        occa::memory o_O2  = wrap(O2,(size_t) nvar*nvar*mesh.nintface);
+        occa::memory o_rhs = wrap(rhs,(size_t) nvar*mesh.nelem);
+        return setJacobian(nvar,o_D,o_O1,o_O2,o_rhs);
+    }
+    if(prepare(nvar)) return TRIBLOCK_ERROR;
+
+    /* host: views of the caller arrays (slot-ordered copies with
+     * line_order), packed A assembled on the host */
+    const int realloc = (location != TRIBLOCK_HOST || Jac.nrhs != 1);
+    Jac.fromArrays(nvar,mesh.interleave ? mesh.nelem_native:mesh.nelem,mesh.nintface,D,O1,O2,rhs);
+    Jac.reorderLines(mesh);
+    Jac.lowmem = opts.getInt("lowmem",0);
+    Jac.assembleTriBlocks(mesh);
+    if(realloc) Jac.setupDevice(gpu);
+
+    /* blocks are streamed by factor() */
+    Jac.vectorsToDevice(xfer);
+    staged = 1;
+
+    if(realloc){
+        delete solver;
+        solver = nullptr;
+    }
+    location = TRIBLOCK_HOST;
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::setJacobian(int nvar,occa::memory &o_D,occa::memory &o_O1,occa::memory &o_O2,
+                                occa::memory &o_rhs){
+    if(prepare(nvar)) return TRIBLOCK_ERROR;
+
+    Jac.wrapDevice(gpu,nvar,mesh.nelem,mesh.nintface,o_D,o_O1,o_O2,o_rhs);
+    staged = 0;
+
+    /* low-memory kernels: rebuild a solver set up for host blocks */
+    if(location != TRIBLOCK_DEVICE){
+        delete solver;
+        solver = nullptr;
+    }
+    location = TRIBLOCK_DEVICE;
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::setRhs(int nrhs,const double *B){
+    if(location != TRIBLOCK_HOST){
+        printf("\x1B[1;31mERROR: triblock_set_rhs needs a TRIBLOCK_HOST Jacobian first\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+    xfer.finish();
+
+    /* (nvar,nrhs,nelem): one record of nvar*nrhs per element */
+    const int nrec = Jac.nvar*nrhs;
+    std::vector<double> slots;
+    if(mesh.interleave){
+        slots.resize((size_t) nrec*mesh.nelem);
+        mesh.fromNative(nrec,B,slots.data());
+        B = slots.data();
+    }
+
+    /* the device factors do not depend on nrhs (nrhs>1 runs the plain
+     * fp64 path, factors in Jac): only the sweep kernels are rebuilt,
+     * the caller's D may already be gone */
+    const int rebuild = (nrhs != Jac.nrhs);
+    if(rebuild){
+        const size_t n = (size_t) nrec*mesh.nelem;
+        Jac.o_rhs = gpu.malloc<double>(n);
+        Jac.o_U   = gpu.malloc<double>(n);
+        Jac.o_dU  = gpu.malloc<double>(n);
+        Jac.o_res = gpu.malloc<double>(n);
+        delete solver;
+        solver = nullptr;
+    }
+    Jac.setNrhs(nrhs,B);
+    xfer.upload(Jac.o_rhs,Jac.rhs.data(),Jac.rhs.size());
+
+    if(rebuild && factored && build()){
+        factored = 0;
+        return TRIBLOCK_ERROR;
+    }
+    return TRIBLOCK_SUCCESS;
+}
+
+/* LineSolver for the current options and nrhs: kernels only, no factors */
+int TriBlockSolver::build(){
+    /* option combinations are checked before any kernel is built */
+    LineSolver *s = new LineSolver(gpu,mesh,Jac,opts);
+    const std::string err = s->check();
+    if(!err.empty()){
+        printf("\x1B[1;31mERROR: triblock options: %s\x1B[0m\n",err.c_str());
+        delete s;
+        return TRIBLOCK_ERROR;
+    }
+
+    KernelCache kcache(gpu);
+    if(kcache.warm(Jac.nvar,mesh.max_line_nelem,opts)) gpu.warm = 1;
+
+    solver = s;
+    solver->setup();
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::factor(){
+    if(location < 0){
+        printf("\x1B[1;31mERROR: set the triblock Jacobian before factoring\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+
+    if(!solver && build()) return TRIBLOCK_ERROR;
+
+    if(staged){
+        /* lines are factored as their blocks arrive (LineSolver::factor(Transfer&)) */
+        if(opts.getInt("overlap",1)){
+            solver->factor(xfer);
+        } else {
+            Jac.blocksToDevice(xfer,0,1);
+            xfer.finish();
+            solver->factor();
+        }
+        staged = 0;
+    } else {
+        solver->factor();
+    }
+    factored = 1;
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::solve(double *U,int where){
+    if(!factored && factor()) return TRIBLOCK_ERROR;
+    const int nrec = Jac.nvar*Jac.nrhs;
+    if(where == TRIBLOCK_DEVICE){
+        occa::memory o_U = wrap(U,(size_t) nrec*mesh.nelem);
+        return solve(o_U);
+    }
+
+    /* host initial guess in, solution out, staged through pinned memory;
+     * line_order maps them between element and slot order */
+    const size_t n = (size_t) nrec*mesh.nelem;
+    if(mesh.interleave){
+        mesh.fromNative(nrec,U,Jac.U.data());
+        xfer.upload(Jac.o_U,Jac.U.data(),n);
+    } else {
+        xfer.upload(Jac.o_U,U,n);
+    }
+    xfer.finish();
+
+    iterate();
+
+    gpu.device.finish();
+    if(mesh.interleave){
+        Jac.downloadSolution(xfer);
+        xfer.finish();
+        mesh.toNative(nrec,Jac.U.data(),U);
+    } else {
+        xfer.download(U,Jac.o_U,n);
+        xfer.finish();
+    }
+    return TRIBLOCK_SUCCESS;
+}
+
+int TriBlockSolver::solve(occa::memory &o_U){
+    if(!factored && factor()) return TRIBLOCK_ERROR;
+    if(mesh.interleave){
+        printf("\x1B[1;31mERROR: triblock line_order needs a TRIBLOCK_HOST solution array\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+
+    /* the caller's buffer holds the initial guess and receives the solution */
+    occa::memory o_own = Jac.o_U;
+    Jac.o_U = o_U;
+    iterate();
+    gpu.device.finish();
+    Jac.o_U = o_own;
+    return TRIBLOCK_SUCCESS;
+}
+
+void TriBlockSolver::iterate(){
+    const int iters = opts.getInt("iters",30);
+    Convergence conv(gpu,opts);
+    conv.setup((size_t) Jac.nvar*Jac.nrhs*mesh.nelem,iters);
+
+    solver->reset();
+    solver->residual();
+    conv.check(0,Jac.o_res);
+
+    niter = 0;
+    while(niter < iters){
+        solver->solve();
+        solver->update();
+        solver->residual();
+        if(conv.check(++niter,Jac.o_res)) break;
+    }
+    conv.finish();
+
+    resNorm = conv.histL2.empty() ? 0.0:conv.histL2.back();
+    status = conv.status;
+}
+
+occa::memory TriBlockSolver::wrap(const double *ptr,size_t count){
+    return gpu.device.wrapMemory<double>(ptr,count);
+}
@@ -0,0 +1,70 @@
+/**
+ * \file    Variants.cxx
+ * \author  akirby
+ *
+ * \brief Variants class implementation
+ */
+
+/* header files */
+#include "Variants.hxx"
+
+/* built-in variants: solver options on top of the command line */
+static const char *variant_table[][2] = {
+    {"default",  "unroll=1"},
+    {"generic",  "unroll=0"},
+    {"batched",  "unroll=0,lines_per_block=4"},
+    {"schedule", "unroll=0,schedule=1"},
+    {"cr",       "unroll=0,cr_min=64"},
+    {"fused",    "unroll=0,fused=1"},
+    {"lowmem",   "unroll=0,lowmem=1"},
+    {"fp32",     "unroll=0,precision=fp32"},
+    {"bf16",     "unroll=0,precision=bf16"},
+    {"nrhs4",    "unroll=0,nrhs=4"},
+};
+#define NUM_VARIANTS (int) (sizeof(variant_table)/sizeof(variant_table[0]))
+
+int Variants::count(){
+    return NUM_VARIANTS;
+}
+
+const char *Variants::name(int v){
+    return variant_table[v][0];
+}
+
+const char *Variants::settings(int v){
+    return variant_table[v][1];
+}
+
+std::vector<std::string> Variants::list(const Options &opts,const std::string &key,const std::string &def){
+    std::vector<std::string> names = opts.getList(key,def);
+    if(names.size() == 1 && names[0] == "all"){
+        names.clear();
+        for(int v = 0; v < NUM_VARIANTS; ++v) names.push_back(variant_table[v][0]);
+    }
+    return names;
+}
+
+bool Variants::lookup(const Options &opts,const std::string &name,std::string &settings){
+    if(opts.has("variant." + name)){
+        settings = opts.getString("variant." + name,"");
+        return true;
+    }
+    for(int v = 0; v < NUM_VARIANTS; ++v){
+        if(name == variant_table[v][0]){
+            settings = variant_table[v][1];
+            return true;
+        }
+    }
+    return false;
+}
+
+Options Variants::merge(const Options &opts,const std::string &settings){
+    Options merged = opts;
+    std::stringstream ss(settings);
+    std::string kv;
+    while(std::getline(ss,kv,',')){
+        const size_t eq = kv.find('=');
+        if(eq != std::string::npos) merged.set(kv.substr(0,eq),kv.substr(eq+1));
+    }
+    return merged;
+}
@@ -9,6 +9,17 @@
 #include "Platform.hxx"
 #include "Jacobian.hxx"
 #include "Mesh.hxx"
+#include "TriBlockFile.hxx"
+#include "Generator.hxx"
+#include "Partition.hxx"
+#include "Transfer.hxx"
+#include "LineSolver.hxx"
+#include "Convergence.hxx"
+#include "Krylov.hxx"
+#include "Autotuner.hxx"
+#include "KernelCache.hxx"
+#include "Reference.hxx"
+#include "Options.hxx"
 
 int main(int argc,char **argv){
     occa::streamTag start,end;
@@ -26,7 +37,7 @@ int main(int argc,char **argv){
     /* Parse Input Arguments */
     /* ===================== */
     std::cout << "+================================================================================+" << std::endl;
-    printf(" >>>>         " GREEN "./triblock.exe" COLOR_OFF " <compute_mode> <device_id> <block_size>         <<<< \n" COLOR_OFF);
+    printf(" >>>>         " GREEN "./triblock.exe" COLOR_OFF " <compute_mode> <device_id> <block_size> [key=value] <<<< \n" COLOR_OFF);
     printf(SPACEBLK1 "<compute_mode> SERIAL (%d): enabled=? %d\n",SERIAL_MODE,occa::modeIsEnabled("Serial"));
     printf(SPACEBLK2 "   HIP (%d): enabled=? %d\n",   HIP_MODE,occa::modeIsEnabled("HIP"));
     printf(SPACEBLK2 "  CUDA (%d): enabled=? %d\n",  CUDA_MODE,occa::modeIsEnabled("CUDA"));
@@ -34,24 +45,80 @@ int main(int argc,char **argv){
     printf(SPACEBLK2 "OpenMP (%d): enabled=? %d\n",OPENMP_MODE,occa::modeIsEnabled("OpenMP"));
     printf(SPACEBLK2 " DPC++ (%d): enabled=? %d\n", DPCPP_MODE,occa::modeIsEnabled("dpcpp"));
     printf(SPACEBLK2 " Metal (%d): enabled=? %d\n", METAL_MODE,occa::modeIsEnabled("Metal"));
+    printf(SPACEBLK2 "Native (%d): enabled=? %d\n",NATIVE_MODE,occa::modeIsEnabled("Serial"));
 
     if (argc > 1) {
         std::string arg1 = argv[1];
         if (arg1 == "--help" || arg1 == "-help") {
             // Print usage information
             std::cout <<              "Arguments:\n"
-                         "  compute_mode: 0=Serial, 1=HIP, 2=CUDA, 3=OpenCL, 4=OpenMP, 5=DPC++, 6=Metal (apple)\n"
+                         "  compute_mode: 0=Serial, 1=HIP, 2=CUDA, 3=OpenCL, 4=OpenMP, 5=DPC++, 6=Metal (apple), 7=Native CPU\n"
                          "  device_id:    Device ID on node\n"
-                         "  block_size:   Size of the matrix sub-block (i.e., # of variables/eqns; e.g., 9x9 default)\n";
+                         "  block_size:   Size of the matrix sub-block (i.e., # of variables/eqns; e.g., 9x9 default)\n"
+                         "  MPI:          mpirun -np N distributes whole lines over N ranks with a halo exchange\n"
+                         "                (solver=jacobi; fused, lowmem, adjoint, nrhs and line_order off)\n"
+                         "Options:\n"
+                         "  iters=N:      Number of line-Jacobi iterations (default 30)\n"
+                         "  precision=P:  Factored block storage: fp64 (default), fp32, bf16, fp16\n"
+                         "  fused=0|1:    Fuse U update and line-local residual into the solve (default 0)\n"
+                         "  lines_per_block=N: Batch N lines per block, NVAR^2 threads each (default 0: off)\n"
+                         "  cr_min=N:     Block cyclic reduction for lines with >= N elements (default 0: off)\n"
+                         "  schedule=0|1: Length-binned launches, Jacobi kernel for length-1 lines (default 0)\n"
+                         "  line_order=W: Line-ordered storage, k-th blocks of W lines interleaved (default 0: off;\n"
+                         "                pair with lines_per_block=W for coalesced batched sweeps)\n"
+                         "  check_every=N: Residual norm check interval, reduced on the device (default 1)\n"
+                         "  tol_abs=X, tol_rel=X: Stop when ||r||_2 <= X, or <= X*||r0||_2 (default 0: off)\n"
+                         "  tol_div=X:    Stop as diverged when ||r||_2 > X*||r0||_2 (default 1e8)\n"
+                         "  solver=S:     jacobi (default), gmres or fgmres (line-Jacobi preconditioned; fused=0)\n"
+                         "  restart=N:    GMRES restart length (default 30)\n"
+                         "  pc_sweeps=N:  Line-Jacobi sweeps per preconditioner application (default 1)\n"
+                         "  nrhs=K:       Solve K right-hand sides per sweep, blocks reused across all K; columns\n"
+                         "                are the file rhs scaled per variable (default 1)\n"
+                         "  adjoint=0|1:  Also solve J^T*lambda = rhs with the forward factors (default 0)\n"
+                         "  update_steps=N: Perturb a subset of lines N times, refactor only those, re-solve (default 0)\n"
+                         "  update_frac=X: Fraction of lines changed per update step (default 0.1)\n"
+                         "  factor_reuse=K: Keep stale factors for up to K updates, residual always fresh (default 0)\n"
+                         "  lowmem=0|1:   No device copies of jacD, packed A or U0; residual from the factors (default 0)\n"
+                         "  unroll=0|1:   Unrolled block kernels for NVAR = 5, 7, 9, 13, generic otherwise (default 1)\n"
+                         "  vec_block=N:  Threads per block of the vector copy/add kernels (default 256)\n"
+                         "  tune=0|1|2:   Pick unroll/lines_per_block/schedule/cr_min/vec_block from the tuning\n"
+                         "                database, timing all variants on a miss (2: always re-tune; default 0)\n"
+                         "  tune_file=F:  Tuning database (default triblock_tuning.db next to the OCCA cache dir)\n"
+                         "  tune_reps=N:  Timed sweeps per tuning trial (default 10)\n"
+                         "  overlap=0|1:  Upload the Jacobian blocks in parts during the factorization, factoring\n"
+                         "                lines whose blocks have arrived (default 1; off with tune)\n"
+                         "  upload_parts=N: Block upload parts with overlap=1 (default 0: one per 64 MB, <= 16)\n"
+                         "  gen=G:        Synthetic system instead of the data files: structured or bl (boundary layer)\n"
+                         "  gen_ni=N, gen_nj=N: Cells along and across the lines (default 64, 60; gen_nelem=N sets nj)\n"
+                         "  gen_line_min=N, gen_line_max=N: Line length range (default ni, ni; bl: wall lines only)\n"
+                         "  gen_skew=X:   Line length skew, 1 uniform, >1 mostly short lines (default 1)\n"
+                         "  gen_dominance=X: Diagonal over off-diagonal row sum (default 2); gen_aniso=X: in-line\n"
+                         "                coupling scale (default 1); gen_shuffle=0|1: random numbering; gen_seed=N\n"
+                         "  profile=0|1:  Per-kernel timers, launch counts and modeled GB/s, summary at exit (default 0)\n"
+                         "  profile_file=F: Chrome trace of every timed scope (default triblock_trace.json; empty: none)\n"
+                         "  profile_bins=0|1: Time each line-length bin of schedule=1/lines_per_block runs (default 0)\n"
+                         "  profile_counters=0|1: Hardware counters on CPU modes via perf_event_open (default 1)\n"
+                         "  profile_max_events=N: Trace events kept per rank (default 1000000)\n"
+                         "  verify=0|1:   Re-run the sweeps against the host port of src/F90/linesmoothLU.f90 and\n"
+                         "                compare dU, U, res per sweep; exit status 1 on a mismatch (default 0;\n"
+                         "                solver=jacobi only, not included in profile=1)\n"
+                         "  verify_tol=X: Error allowed per sweep (default by precision: fp64 1e-10, fp32 1e-4,\n"
+                         "                fp16 1e-2, bf16 5e-2)\n"
+                         "Environment:\n"
+                         "  OCCA_CACHE_DIR: Kernel cache (default ./.occa); point at a triblock_aot.exe cache to\n"
+                         "                skip JIT compilation for the precompiled NVAR/MAX_LINE_ELEM/mode sets\n";
             std::cout << "+================================================================================+" << std::endl;
             MPI_Finalize();
             return 0;
         }
     }
 
-    if(argc > 1) compute_mode = std::stoi(argv[1]);
-    if(argc > 2) device_id    = std::stoi(argv[2]);
-    if(argc > 3) block_size   = std::stoi(argv[3]);
+    Options opts(argc,argv);
+    if(opts.positional.size() > 0) compute_mode = std::stoi(opts.positional[0]);
+    if(opts.positional.size() > 1) device_id    = std::stoi(opts.positional[1]);
+    if(opts.positional.size() > 2) block_size   = std::stoi(opts.positional[2]);
+    iters = opts.getInt("iters",iters);
+    int precision = LineSolver::parsePrecision(opts.getString("precision","fp64"));
     int nvar = block_size;
 
     std::cout << " -------------------------------------------------------------------------------- " << std::endl;
@@ -64,8 +131,10 @@ int main(int argc,char **argv){
                      (compute_mode == OPENCL_MODE) ? "OpenCL MODE":
                      (compute_mode == OPENMP_MODE) ? "OpenMP MODE":
                      (compute_mode ==  DPCPP_MODE) ?  "DPC++ MODE":
-                     (compute_mode ==  METAL_MODE) ?  "Metal MODE":"UNKNOWN")
+                     (compute_mode ==  METAL_MODE) ?  "Metal MODE":
+                     (compute_mode == NATIVE_MODE) ? "Native MODE":"UNKNOWN")
               << COLOR_OFF ", Device ID: " GREEN << device_id
+              << COLOR_OFF ", Precision: " GREEN << LineSolver::precisionName(precision)
               << COLOR_OFF << std::endl;
     std::cout << " -------------------------------------------------------------------------------- " << std::endl;
 
@@ -79,64 +148,116 @@ int main(int argc,char **argv){
     /* ========================== */
     Platform gpu(MPI_COMM_WORLD,compute_mode,device_id);
 
+    /* prefer the versioned format (see triblock_convert.exe) when present */
+    const bool tbk = (access(TRIBLOCK_FILE_NAME,R_OK) == 0);
+
+    /* synthetic system (gen=...): generated in memory at the requested NVAR */
+    const bool synth = opts.has("gen");
+    Generator gen(opts);
+
     Mesh mesh;
-    mesh.fromFile();
-    mesh.setupDevice(gpu);
-    mesh.toDevice();
-    gpu.device.finish();
+    if(synth){
+        gen.generateMesh();
+        gen.generateBlocks(nvar);
+        gen.toMesh(mesh);
+    } else {
+        tbk ? mesh.fromFile(TRIBLOCK_FILE_NAME):mesh.fromFile();
+    }
+
+    /* kernel cache: AOT binaries load directly, a missing set compiles in the background */
+    KernelCache kcache(gpu);
+    if(kcache.warm(nvar,mesh.max_line_nelem,opts)){
+        gpu.warm = 1;
+        if(!gpu.rank) printf("kernel cache: warm (%s)\n",kcache.manifest.c_str());
+    } else {
+        kcache.prefetch(nvar,mesh.max_line_nelem,opts);
+    }
 
     Jacobian Jac;
-    Jac.fromFile(mesh.nlineelem);
-    Jac.assembleTriBlocks(mesh);
+    if(synth){
+        gen.toJacobian(Jac);
+    } else {
+        tbk ? Jac.fromFile(mesh.nlineelem,TRIBLOCK_FILE_NAME):Jac.fromFile(mesh.nlineelem);
+    }
+    if(Jac.nelem != mesh.nelem || Jac.nintface != mesh.nintface){
+        printf("\x1B[1;31mERROR: Jacobian and mesh sizes do not match\x1B[0m\n");
+        MPI_Abort(MPI_COMM_WORLD,1);
+    }
     Jac.resizeBlockSize(nvar);
+    Jac.assembleTriBlocks(mesh);
+
+    /* optional line-ordered (interleaved) storage */
+    if(opts.getInt("line_order",0) > 0){
+        mesh.reorderLines(opts.getInt("line_order",0));
+        Jac.reorderLines(mesh);
+    }
+
+    /* MPI runs: whole lines per rank, local Mesh/Jacobian with ghosts */
+    Partition part(gpu);
+    if(gpu.nrank > 1){
+        if(opts.getInt("line_order",0) > 0){
+            printf("\x1B[1;31mERROR: line_order requires a single MPI rank\x1B[0m\n");
+            MPI_Abort(MPI_COMM_WORLD,1);
+        }
+        part.decompose(mesh,Jac);
+        part.printStats();
+    }
+
+    /* optional batched right-hand sides: synthetic columns from the file rhs */
+    const int nrhs = opts.getInt("nrhs",1);
+    if(nrhs > 1) Jac.setNrhs(nrhs,Generator::batchRhs(Jac,nrhs).data());
+
+    /* pinned, chunked uploads on the transfer stream; with overlap=1 the
+     * Jacobian blocks stream in during the factorization (the tuner
+     * needs them up front) */
+    const int overlap = opts.getInt("overlap",1) && !opts.getInt("tune",0);
+    Transfer xfer(gpu);
+
+    mesh.setupDevice(gpu);
+    mesh.toDevice(xfer);
+
+    Jac.lowmem = opts.getInt("lowmem",0);
     Jac.setupDevice(gpu);
-    Jac.toDevice();
-    gpu.device.finish();
+    Jac.vectorsToDevice(xfer);
+    if(!overlap){
+        Jac.blocksToDevice(xfer,0,1);
+        xfer.finish();
+    }
 
     std::cout << "=========================================\n";
     std::cout << "GPU Memory Allocated (MB): "
               << (gpu.device.memoryAllocated()/1024./1024.)
               << std::endl;
+    if(Jac.lowmem){
+        std::cout << "Low-Memory Mode Saved (MB): "
+                  << (Jac.lowmemSavedBytes()/1024./1024.)
+                  << " (jacD, A, U0)" << std::endl;
+    }
     std::cout << "=========================================\n";
 
     /* ======================================= */
     /* Build Compute Kernels (JIT-compilation) */
     /* ======================================= */
-    occa::properties kernelProps;
-    kernelProps["defines/NVAR"] = nvar;
-    kernelProps["defines/MAX_LINE_ELEM"] = mesh.max_line_nelem;
-    kernelProps["defines/p_Nblock"] = (nvar+9-1)/9;
-    printf("p_Nblock = %d\n",(nvar+9-1)/9);
+    /* background kernel builds land in the cache before any kernel is built here */
+    kcache.wait();
 
+    /* kernel variant autotuning: tuning database or timed trials */
+    if(opts.getInt("tune",0) > 0){
+        Autotuner tuner(gpu,mesh,Jac,opts);
+        tuner.apply(opts);
+    }
 
-    std::cout << GREEN "Compiling Device Kernels..." COLOR_OFF;
-    double t1 = MPI_Wtime();
+    /* launch instrumentation (after tuning, whose trials are not profiled) */
+    gpu.prof.enable(opts);
 
-    /* utility functions */
-    occa::kernel copyAtoBjac = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","copyAtoBjac",kernelProps);
-    occa::kernel copyAtoB    = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","copyAtoB",kernelProps);
-    occa::kernel addAtoB     = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","addAtoB",kernelProps);
-
-    /* line factorization */
-    //occa::kernel lineLU_v1   = gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v1.okl","lineLU",kernelProps);
-    occa::kernel lineLU_v2   = gpu.buildKernel(SOLVER_DIR "/okl/lineLU_v2.okl","lineLU",kernelProps);
-
-    /* matrix solve */
-    //occa::kernel solveDU_v5  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","linesmoothLU_solveDU",kernelProps);
-    //occa::kernel solveDU_v6  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v6.okl","linesmoothLU_solveDU",kernelProps);
-    //occa::kernel solveDU_v7  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v7.okl","linesmoothLU_solveDU",kernelProps);
-    //occa::kernel solveDU_v8  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v1.okl","triblock_solveDU",kernelProps);
-    //occa::kernel solveDU_v9  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v2.okl","triblock_solveDU",kernelProps);
-    occa::kernel solveDU_v10 = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v3.okl","triblock_solveDU",kernelProps);
-
-    /* linear residual calculation */
-    //occa::kernel lineRes_v5  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v5.okl","linesolver_lineRes",kernelProps);
-    //occa::kernel lineRes_v6  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v6.okl","linesolver_lineRes",kernelProps);
-    //occa::kernel lineRes_v7  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_v7.okl","linesolver_lineRes",kernelProps);
-    //occa::kernel lineRes_v8  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v1.okl","triblock_lineRes",kernelProps);
-    //occa::kernel lineRes_v9  = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v2.okl","triblock_lineRes",kernelProps);
-    occa::kernel lineRes_v10 = gpu.buildKernel(SOLVER_DIR "/okl/linesmoothLU_TriBlock_v3.okl","triblock_lineRes",kernelProps);
+    LineSolver solver(gpu,mesh,Jac,opts);
+    Convergence conv(gpu,opts);
+    if(gpu.nrank > 1) solver.part = &part;
 
+    std::cout << GREEN "Compiling Device Kernels..." COLOR_OFF;
+    double t1 = MPI_Wtime();
+    solver.setup();
+    conv.setup(Jac.res.size(),iters);
     double t2 = MPI_Wtime();
     std::cout << GREEN "done: " COLOR_OFF << t2-t1 << " seconds." << std::endl;
 
@@ -146,47 +267,67 @@ int main(int argc,char **argv){
     double linesolver_mem = (mesh.nbytes + Jac.nbytes)*sizeof(double);
     linesolver_mem /= (double)1e9; // GB
 
-    double duMem = 1*Jac.jacDLU.size()*sizeof(double)
-                 + 1*Jac.DinvC.size()*sizeof(double)
-                 + 1*Jac.A.size()*sizeof(double)
-                 + 4*Jac.dU.size()*sizeof(double) // 2 loads, 2 stores
-                 + 1*Jac.res.size()*sizeof(double)
-                 + 1*mesh.linesize.size()*sizeof(int)
-                 + 1*mesh.linepoint.size()*sizeof(int)
-                 + 1*mesh.lines.size()*sizeof(int)
-                 + 1*mesh.lineface.size()*sizeof(int);
-    duMem *= iters / (double)1e9; // GB
-
-    double cpMem = (5*Jac.dU.size()*sizeof(double))*(iters + 2./5.);
-    cpMem /= (double)1e9; // GB
-
-    double lrMem = Jac.jacD.size()*sizeof(double)
-                 + Jac.jacO1.size()*sizeof(double)
-                 + Jac.jacO2.size()*sizeof(double)
-                 + 5*mesh.nelem*nvar*sizeof(double) // U: spMV w/ 5 blocks for each element
-                 + 2*Jac.res.size()*sizeof(double)  // 1 load, 1 store
-                 + mesh.epoint.size()*sizeof(int)
-                 + mesh.ef.size()*sizeof(int)
-                 + mesh.fc.size()*sizeof(int)
-                 + mesh.linesize.size()*sizeof(int)
-                 + mesh.linepoint.size()*sizeof(int)
-                 + mesh.lines.size()*sizeof(int)
-                 + mesh.lineface.size()*sizeof(int);
-    lrMem *= iters / (double)1e9; // GB
+    /* verify=1: initial guess for the reference run */
+    const int verify = opts.getInt("verify",0);
+    const std::string method = opts.getString("solver","jacobi");
+    if(verify && gpu.nrank > 1){
+        printf("\x1B[1;31mERROR: verify=1 runs on a single MPI rank\x1B[0m\n");
+        MPI_Abort(MPI_COMM_WORLD,1);
+    }
+    if(verify && method != "jacobi"){
+        printf("\x1B[1;31mERROR: verify=1 checks the line-Jacobi sweeps: use solver=jacobi\x1B[0m\n");
+        MPI_Abort(MPI_COMM_WORLD,1);
+    }
+    const std::vector<double> U0 = verify ? std::vector<double>(Jac.U.begin(),Jac.U.end()):std::vector<double>();
 
     /* ====================================================================== */
     /* Factor Block Jacobian Diagonals                                        */
     /* ====================================================================== */
     gpu.device.finish();
+    double up_wall = MPI_Wtime();
     start = gpu.device.tagStream();
-        copyAtoBjac(mesh.nelem,Jac.o_jacD,Jac.o_jacDLU);
-        lineLU_v2(mesh.nelem,mesh.nintface,mesh.nline,
-                  mesh.o_fc,mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,mesh.o_lineface,
-                  Jac.o_jacDLU,Jac.o_jacO1,Jac.o_jacO2,Jac.o_jacDinvC);
+        overlap ? solver.factor(xfer):solver.factor();
     end = gpu.device.tagStream();
     gpu.device.finish();
+    up_wall = MPI_Wtime() - up_wall;
     double LU_time = gpu.device.timeBetween(start, end);
     printf("   LU OCCA Time: %f\n",LU_time);
+    if(overlap) printf("   Upload+LU Wall Time: %f\n",up_wall);
+
+    /* ====================================================================== */
+    /* Krylov Solver: line-Jacobi preconditioned GMRES/FGMRES                 */
+    /* ====================================================================== */
+    if(method == "gmres" || method == "fgmres"){
+        Krylov krylov(gpu,solver,opts);
+        krylov.setup();
+
+        gpu.device.finish();
+        start = gpu.device.tagStream();
+            krylov.solve(iters);
+        end = gpu.device.tagStream();
+        gpu.device.finish();
+        double kr_time = gpu.device.timeBetween(start, end);
+
+        std::cout << "-----------------------------------------\n";
+        printf("[%s] Residual History:\n",method.c_str());
+        for(size_t k = 0; k < krylov.history.size(); ++k){
+            printf("  %4d  %.6e  %.6e\n",(int) k,krylov.history[k],krylov.history[k]/krylov.history[0]);
+        }
+        std::cout << "-----------------------------------------\n";
+        printf("[%s] Iterations: %d (%d preconditioner applications, %d line sweeps)\n",
+               method.c_str(),krylov.niter,krylov.nprec,krylov.nprec*krylov.pcSweeps);
+        printf("[%s] Final ||r||_2: %.6e (%s)\n",method.c_str(),krylov.resNorm,
+               krylov.converged ? "converged":"not converged");
+        printf("[%s] Total Time: %f\n",method.c_str(),kr_time+LU_time);
+        std::cout << "-----------------------------------------\n";
+
+        gpu.prof.finish();
+        MPI_Finalize();
+        return 0;
+    } else if(method != "jacobi"){
+        printf("\x1B[1;31mERROR: unknown solver '%s' (jacobi, gmres, fgmres)\x1B[0m\n",method.c_str());
+        MPI_Abort(MPI_COMM_WORLD,1);
+    }
 
     /* ====================================================================== */
     /* Iterate Line Solver                                                    */
@@ -199,37 +340,45 @@ int main(int argc,char **argv){
     double cp_time = 0.0;
 
     gpu.device.finish();
+    MPI_Barrier(gpu.comm);
+    double wall_time = MPI_Wtime();
     start = gpu.device.tagStream();
-        copyAtoB(mesh.nelem,Jac.o_rhs,Jac.o_res);
+        solver.reset();
     end = gpu.device.tagStream();
     cp_time += gpu.device.timeBetween(start, end);
+    conv.check(0,Jac.o_res);
 
-    for(int p = 0; p < iters; ++p){
+    int niter = 0;
+    while(niter < iters){
         start = gpu.device.tagStream();
-            solveDU_v10(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
-                        mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
-                        Jac.o_jacDLU,Jac.o_jacDinvC,Jac.o_A,Jac.o_dU,Jac.o_res);
+            solver.solve();
         end = gpu.device.tagStream();
         dU_time += gpu.device.timeBetween(start, end);
 
         start = gpu.device.tagStream();
-            addAtoB(mesh.nelem,Jac.o_dU,Jac.o_U);
-            copyAtoB(mesh.nelem,Jac.o_rhs,Jac.o_res);
+            solver.update();
         end = gpu.device.tagStream();
         cp_time += gpu.device.timeBetween(start, end);
 
         start = gpu.device.tagStream();
-            lineRes_v10(mesh.nelem,mesh.nintface,mesh.eftot,mesh.nline,mesh.nlineelem,
-                        mesh.o_epoint,mesh.o_ef,mesh.o_fc,
-                        mesh.o_linesize,mesh.o_linepoint,mesh.o_lines,
-                        Jac.o_jacD,Jac.o_jacO1,Jac.o_jacO2,
-                        Jac.o_U,Jac.o_res);
+            solver.residual();
         end = gpu.device.tagStream();
         LR_time += gpu.device.timeBetween(start, end);
+
+        if(conv.check(++niter,Jac.o_res)) break;
     }
     gpu.device.finish();
+    conv.finish();
+    wall_time = MPI_Wtime() - wall_time;
     double v10_time = dU_time + cp_time + LR_time;
 
+    /* host solution: copied back while the adjoint runs */
+    Jac.downloadSolution(xfer);
+
+    double duMem = solver.solveBytes()*niter/(double)1e9; // GB
+    double cpMem = (solver.updateBytes()*niter + solver.resetBytes())/(double)1e9; // GB
+    double lrMem = solver.residualBytes()*niter/(double)1e9; // GB
+
     double du_bytes = (Jac.jacDLU.size()
                      + Jac.jacD.size()
                      + Jac.A.size()
@@ -247,10 +396,156 @@ int main(int argc,char **argv){
     /* ====================================================================== */
 
     std::cout << "-----------------------------------------\n";
-    printf("[v10] Iterations: %d\n",iters);
+    printf("[v10] Residual History:\n");
+    conv.printHistory();
+
+    std::cout << "-----------------------------------------\n";
+    printf("[v10] Iterations: %d\n",niter);
     printf("[v10] Total Time: %f\n",v10_time+LU_time);
     std::cout << "-----------------------------------------\n";
 
+    /* ====================================================================== */
+    /* Verification: same sweeps in lockstep with the reference smoother      */
+    /* ====================================================================== */
+    int verifyFailed = 0;
+    if(verify){
+        xfer.finish();
+
+        /* the reference re-runs the sweeps: keep them out of the profile */
+        const int profiled = gpu.prof.enabled;
+        gpu.prof.enabled = 0;
+
+        Reference ref(mesh,Jac);
+        ref.tol = Reference::tolerance(opts);
+        verifyFailed = !ref.verify(solver,U0,niter);
+        gpu.prof.enabled = profiled;
+
+        printf("[verify] Reference: src/F90/linesmoothLU.f90 (host port), error over max|U_ref| (dU, U), max|rhs| (res)\n");
+        ref.printHistory();
+        verifyFailed ?
+            printf("[verify] \x1B[1;31mFAIL\x1B[0m: sweep %d exceeds %.1e per sweep\n",ref.failIter,ref.tol):
+            printf("[verify] \x1B[1;92mPASS\x1B[0m: %d sweeps within %.1e per sweep\n",niter,ref.tol);
+        std::cout << "-----------------------------------------\n";
+    }
+
+    /* scaling: slowest rank sets the wall time; compare runs for efficiency */
+    if(gpu.nrank > 1){
+        double max_wall;
+        MPI_Reduce(&wall_time,&max_wall,1,MPI_DOUBLE,MPI_MAX,0,gpu.comm);
+        if(!gpu.rank){
+            const double rate = (double) part.nelem_global*niter/max_wall;
+            printf("[mpi] Ranks: %d, Wall Time (max): %f\n",gpu.nrank,max_wall);
+            printf("[mpi] Throughput: %.4e elem-iters/s total, %.4e per rank\n",rate,rate/gpu.nrank);
+            std::cout << "-----------------------------------------\n";
+        }
+    }
+
+    /* ====================================================================== */
+    /* Adjoint Line Solver: J^T*lambda = g on the forward factorization       */
+    /* ====================================================================== */
+    if(solver.adjoint){
+        std::vector<double> zero(Jac.U.size(),0.0);
+        occa::memory o_lam  = gpu.malloc<double>(zero.size(),zero.data());
+        occa::memory o_dlam = gpu.malloc<double>(zero.size(),zero.data());
+        occa::memory o_resT = gpu.malloc<double>(zero.size(),zero.data());
+
+        Convergence convT(gpu,opts);
+        convT.setup(zero.size(),iters);
+
+        gpu.device.finish();
+        start = gpu.device.tagStream();
+            solver.copyAtoB(mesh.nelem,Jac.o_rhs,o_resT);
+            convT.check(0,o_resT);
+
+            int niterT = 0;
+            while(niterT < iters){
+                solver.solveT(o_dlam,o_resT);
+                solver.addAtoB(mesh.nelem,o_dlam,o_lam);
+                solver.copyAtoB(mesh.nelem,Jac.o_rhs,o_resT);
+                solver.residualT(o_lam,o_resT);
+                if(convT.check(++niterT,o_resT)) break;
+            }
+        end = gpu.device.tagStream();
+        gpu.device.finish();
+        convT.finish();
+        double adj_time = gpu.device.timeBetween(start, end);
+
+        printf("[adjoint] Residual History:\n");
+        convT.printHistory();
+
+        std::cout << "-----------------------------------------\n";
+        printf("[adjoint] Iterations: %d\n",niterT);
+        printf("[adjoint] Total Time: %f (factorization shared with forward)\n",adj_time);
+        std::cout << "-----------------------------------------\n";
+    }
+
+    /* ====================================================================== */
+    /* Incremental Refactorization: change a subset of lines and re-solve     */
+    /* ====================================================================== */
+    const int nsteps = opts.getInt("update_steps",0);
+    const double update_frac = opts.getDouble("update_frac",0.1);
+    xfer.finish();
+    for(int step = 1; step <= nsteps; ++step){
+        const size_t nblk = (size_t) Jac.nvar*Jac.nvar;
+
+        /* deterministic line subset: scale [D] and the in-line faces */
+        std::vector<int> elems,faces;
+        for(int l = 0; l < mesh.nline; ++l){
+            if(((l*7919 + step*104729) % 1000) >= update_frac*1000) continue;
+
+            for(int m = mesh.linepoint[l]; m < mesh.linepoint[l] + mesh.linesize[l]; ++m){
+                const int e = mesh.lines[m];
+                for(size_t q = 0; q < nblk; ++q) Jac.jacD[nblk*e + q] *= 1.02;
+                elems.push_back(e);
+
+                if(m > mesh.linepoint[l]){
+                    const int f = mesh.lineface[m];
+                    for(size_t q = 0; q < nblk; ++q){
+                        Jac.jacO1[nblk*f + q] *= 0.98;
+                        Jac.jacO2[nblk*f + q] *= 0.98;
+                    }
+                    faces.push_back(f);
+                }
+            }
+        }
+
+        gpu.device.finish();
+        start = gpu.device.tagStream();
+            const int nrefactored = solver.updateJacobian(elems,faces);
+        end = gpu.device.tagStream();
+        gpu.device.finish();
+        double up_time = gpu.device.timeBetween(start, end);
+
+        /* warm start from the current U */
+        Convergence convS(gpu,opts);
+        convS.setup(Jac.res.size(),iters);
+
+        start = gpu.device.tagStream();
+            solver.reset();
+            solver.residual();
+            convS.check(0,Jac.o_res);
+
+            int niterS = 0;
+            while(niterS < iters){
+                solver.solve();
+                solver.update();
+                solver.residual();
+                if(convS.check(++niterS,Jac.o_res)) break;
+            }
+        end = gpu.device.tagStream();
+        gpu.device.finish();
+        convS.finish();
+        double step_time = gpu.device.timeBetween(start, end);
+
+        printf("[update %d] %d elems, %d faces: %d of %d lines refactored%s\n",
+               step,(int) elems.size(),(int) faces.size(),nrefactored,mesh.nline,
+               (nrefactored == 0 && !elems.empty()) ? " (stale factors reused)":"");
+        printf("[update %d] Setup Time: %f (full LU %f), %d iterations: %f, ||r||_2 %.6e (%s)\n",
+               step,up_time,LU_time,niterS,step_time,
+               convS.histL2.empty() ? 0.0:convS.histL2.back(),Convergence::statusName(convS.status));
+    }
+    if(nsteps > 0) std::cout << "-----------------------------------------\n";
+
     /* ====================================================================== */
     /* Copy and Display Jacobian Values                                       */
     /* ====================================================================== */
@@ -265,5 +560,7 @@ int main(int argc,char **argv){
 //        printf("\n");
 //    }
     /* ====================================================================== */
+    gpu.prof.finish();
     MPI_Finalize();
+    return verifyFailed;
 }
\ No newline at end of file
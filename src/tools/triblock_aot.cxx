@@ -0,0 +1,88 @@
+/**
+ * File:   triblock_aot.cxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ *
+ * Ahead-of-time kernel build: compiles the default kernel set for every
+ * (mode, NVAR, MAX_LINE_ELEM) combination into one OCCA cache directory
+ * and records each combination in its manifest (see KernelCache). Run
+ * triblock.exe with OCCA_CACHE_DIR pointing at that directory.
+ */
+
+/* header files */
+#include "Platform.hxx"
+#include "KernelCache.hxx"
+#include "Options.hxx"
+
+/* system header files */
+#include <sys/stat.h>
+
+/* comma-separated integer list */
+static std::vector<int> intList(const std::string &s){
+    std::vector<int> v;
+    std::stringstream ss(s);
+    std::string item;
+    while(std::getline(ss,item,',')){
+        if(!item.empty()) v.push_back(std::stoi(item));
+    }
+    return v;
+}
+
+int main(int argc,char **argv){
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-help" || arg == "-h"){
+            std::cout << "Usage: ./triblock_aot.exe [key=value]\n"
+                         "  cache=<dir>          OCCA cache directory to fill (default: ./kernel_cache)\n"
+                         "  modes=<m,...>        compute modes, as in triblock.exe (default: 0)\n"
+                         "  nvar=<n,...>         block sizes (default: 5,7,9,13)\n"
+                         "  max_line_elem=<n,...> longest line of the target meshes (default: 64)\n"
+                         "  device_id=<id>       device to compile on (default: 0)\n"
+                         "  unroll=0|1, vec_block=N  kernel options, as in triblock.exe (default: 1, 256)\n";
+            return 0;
+        }
+    }
+
+    MPI_Init(&argc,&argv);
+    Options opts(argc,argv);
+
+    std::string cache = opts.getString("cache","kernel_cache");
+    if(cache[0] != '/'){
+        char pwd[256];
+        cache = std::string(getcwd(pwd,256) ? pwd:".") + "/" + cache;
+    }
+    const std::vector<int> modes = intList(opts.getString("modes","0"));
+    const std::vector<int> nvars = intList(opts.getString("nvar","5,7,9,13"));
+    const std::vector<int> lens  = intList(opts.getString("max_line_elem","64"));
+    const int device_id = opts.getInt("device_id",0);
+
+    /* Platform picks the cache up from the environment */
+    mkdir(cache.c_str(),0755);
+    setenv("OCCA_CACHE_DIR",cache.c_str(),1);
+    const std::string manifest = KernelCache::manifestPath(cache);
+
+    for(int mode : modes){
+        if(mode == NATIVE_MODE){
+            printf("mode %d: native engine has no device kernels, skipped\n",mode);
+            continue;
+        }
+        Platform gpu(MPI_COMM_WORLD,mode,device_id);
+
+        for(int nvar : nvars){
+            for(int len : lens){
+                const std::string key = KernelCache::comboKey(gpu.device,nvar,len,opts);
+                const std::vector<KernelCache::Spec> specs = KernelCache::kernelSet(nvar,len,opts);
+
+                double t1 = MPI_Wtime();
+                KernelCache::build(gpu.device,specs,manifest,key);
+                double t2 = MPI_Wtime();
+                printf("%s: %d kernels, %f seconds\n",key.c_str(),(int) specs.size(),t2-t1);
+            }
+        }
+    }
+    printf("kernel cache: %s\n",cache.c_str());
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,477 @@
+/**
+ * File:   triblock_bench.cxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ *
+ * Benchmark driver: sweeps kernel variant x NVAR x iteration count x
+ * dataset. Every point runs warmup passes and then timed repetitions of
+ * the factorization and of the line-Jacobi sweep (reset + iters x
+ * solve/update/residual). It reports the median, p10/p90 and min/max per
+ * phase, with GB/s taken from the byte models of the configured solver
+ * (LineSolver::*Bytes). A STREAM-style probe measures the device
+ * bandwidth they are compared against. Results are written as JSON and
+ * CSV for regression tracking.
+ */
+
+/* header files */
+#include "Platform.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "TriBlockFile.hxx"
+#include "Generator.hxx"
+#include "Transfer.hxx"
+#include "LineSolver.hxx"
+#include "Variants.hxx"
+#include "Options.hxx"
+
+/* system header files */
+#include <algorithm>
+#include <ctime>
+
+/* timed phases of one benchmark point */
+#define NUM_PHASES 5
+static const char *phase_names[NUM_PHASES] = {"factor","solve","update","residual","sweep"};
+
+struct Stats {
+    double median,p10,p90,min,max;
+};
+
+struct Result {
+    std::string dataset;
+    std::string variant;
+    std::string settings;
+    int nvar,iters;
+    int nelem,nline;
+    double setup;                   /**< kernel build (s) */
+    double bytes[NUM_PHASES];       /**< byte model per phase */
+    Stats time[NUM_PHASES];
+    Stats wall;                     /**< host wall time of a sweep */
+    double resL2;                   /**< ||r||_2 after the last sweep */
+};
+
+struct StreamResult {
+    std::string kernel;
+    double bytes;
+    Stats time;
+};
+
+/* nearest-rank percentiles, interpolated median */
+static Stats stats(std::vector<double> t){
+    Stats s = {0.0,0.0,0.0,0.0,0.0};
+    if(t.empty()) return s;
+
+    std::sort(t.begin(),t.end());
+    const size_t n = t.size();
+    auto rank = [&](double q){
+        const size_t k = (size_t) std::ceil(q*n);
+        return t[std::min(n-1,(k > 0) ? k-1:0)];
+    };
+    s.median = (n % 2) ? t[n/2]:0.5*(t[n/2-1] + t[n/2]);
+    s.p10 = rank(0.10);
+    s.p90 = rank(0.90);
+    s.min = t.front();
+    s.max = t.back();
+    return s;
+}
+
+static double gbs(double bytes,double time){
+    return (time > 0.0) ? bytes/time/1.0e9:0.0;
+}
+
+static std::string baseName(const std::string &dir){
+    std::string d = dir;
+    if(d == "." || d.empty()){
+        char pwd[256];
+        d = getcwd(pwd,256) ? pwd:".";
+    }
+    while(d.size() > 1 && d.back() == '/') d.pop_back();
+    const size_t slash = d.rfind('/');
+    return (slash == std::string::npos) ? d:d.substr(slash+1);
+}
+
+static std::string jsonString(const std::string &s){
+    std::string out = "\"";
+    for(const char c : s){
+        if(c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static void jsonStats(FILE *fp,const Stats &s){
+    fprintf(fp,"\"median_s\": %.9e, \"p10_s\": %.9e, \"p90_s\": %.9e, \"min_s\": %.9e, \"max_s\": %.9e",
+            s.median,s.p10,s.p90,s.min,s.max);
+}
+
+/* ====================================================================== */
+/* STREAM-style device bandwidth probe                                    */
+/* ====================================================================== */
+static std::vector<StreamResult> streamProbe(Platform &gpu,size_t bytesPerArray,
+                                             int vecBlock,int warmup,int reps){
+    const size_t maxN = 0x7fffffff;
+    const int N = (int) std::min(maxN,bytesPerArray/sizeof(double));
+    const double s = 3.0;
+
+    occa::properties props;
+    props["defines/p_blockSize"] = vecBlock;
+    occa::kernel copy  = gpu.buildKernel(SOLVER_DIR "/okl/stream_v1.okl","streamCopy",props);
+    occa::kernel scale = gpu.buildKernel(SOLVER_DIR "/okl/stream_v1.okl","streamScale",props);
+    occa::kernel add   = gpu.buildKernel(SOLVER_DIR "/okl/stream_v1.okl","streamAdd",props);
+    occa::kernel triad = gpu.buildKernel(SOLVER_DIR "/okl/stream_v1.okl","streamTriad",props);
+
+    std::vector<double> init(N,1.0);
+    occa::memory o_a = gpu.malloc<double>(N,init.data());
+    occa::memory o_b = gpu.malloc<double>(N,init.data());
+    occa::memory o_c = gpu.malloc<double>(N,init.data());
+
+    std::vector<StreamResult> results(4);
+    const char *names[4] = {"copy","scale","add","triad"};
+    const int words[4] = {2,2,3,3};
+    std::vector<std::vector<double>> t(4);
+
+    for(int r = 0; r < warmup + reps; ++r){
+        for(int k = 0; k < 4; ++k){
+            gpu.device.finish();
+            occa::streamTag start = gpu.device.tagStream();
+            switch(k){
+                case 0: copy(N,o_a,o_c);      break;
+                case 1: scale(N,s,o_c,o_b);   break;
+                case 2: add(N,o_a,o_b,o_c);   break;
+                case 3: triad(N,s,o_b,o_c,o_a); break;
+            }
+            occa::streamTag end = gpu.device.tagStream();
+            gpu.device.finish();
+            if(r >= warmup) t[k].push_back(gpu.device.timeBetween(start,end));
+        }
+    }
+
+    for(int k = 0; k < 4; ++k){
+        results[k].kernel = names[k];
+        results[k].bytes = (double) words[k]*N*sizeof(double);
+        results[k].time = stats(t[k]);
+        printf("stream %-6s %10.2f GB/s (median), %10.2f GB/s (best)\n",names[k],
+               gbs(results[k].bytes,results[k].time.median),gbs(results[k].bytes,results[k].time.min));
+    }
+    return results;
+}
+
+/* ====================================================================== */
+/* One benchmark point: factor and sweep timings of a configured solver   */
+/* ====================================================================== */
+static void benchPoint(Platform &gpu,Jacobian &Jac,LineSolver &solver,
+                       int iters,int warmup,int reps,
+                       const std::vector<double> &U0,Result &res){
+    std::vector<double> t[NUM_PHASES];
+    std::vector<double> wall;
+    occa::streamTag start,end;
+
+    /* factorization: repeatable, every call starts from jacD */
+    for(int r = 0; r < warmup + reps; ++r){
+        gpu.device.finish();
+        start = gpu.device.tagStream();
+            solver.factor();
+        end = gpu.device.tagStream();
+        gpu.device.finish();
+        if(r >= warmup) t[0].push_back(gpu.device.timeBetween(start,end));
+    }
+
+    /* sweeps from the initial guess, as in triblock.exe */
+    for(int r = 0; r < warmup + reps; ++r){
+        double dU_time = 0.0;
+        double cp_time = 0.0;
+        double LR_time = 0.0;
+
+        Jac.o_U.copyFrom(U0.data());
+        gpu.device.finish();
+        double wall_time = MPI_Wtime();
+
+        start = gpu.device.tagStream();
+            solver.reset();
+        end = gpu.device.tagStream();
+        cp_time += gpu.device.timeBetween(start,end);
+
+        for(int n = 0; n < iters; ++n){
+            start = gpu.device.tagStream();
+                solver.solve();
+            end = gpu.device.tagStream();
+            dU_time += gpu.device.timeBetween(start,end);
+
+            start = gpu.device.tagStream();
+                solver.update();
+            end = gpu.device.tagStream();
+            cp_time += gpu.device.timeBetween(start,end);
+
+            start = gpu.device.tagStream();
+                solver.residual();
+            end = gpu.device.tagStream();
+            LR_time += gpu.device.timeBetween(start,end);
+        }
+        gpu.device.finish();
+        wall_time = MPI_Wtime() - wall_time;
+
+        if(r < warmup) continue;
+        t[1].push_back(dU_time);
+        t[2].push_back(cp_time);
+        t[3].push_back(LR_time);
+        t[4].push_back(dU_time + cp_time + LR_time);
+        wall.push_back(wall_time);
+    }
+
+    res.bytes[0] = solver.factorBytes();
+    res.bytes[1] = solver.solveBytes()*iters;
+    res.bytes[2] = solver.updateBytes()*iters + solver.resetBytes();
+    res.bytes[3] = solver.residualBytes()*iters;
+    res.bytes[4] = res.bytes[1] + res.bytes[2] + res.bytes[3];
+    for(int p = 0; p < NUM_PHASES; ++p) res.time[p] = stats(t[p]);
+    res.wall = stats(wall);
+
+    /* sanity: residual of the last sweep */
+    std::vector<double> r(Jac.res.size());
+    Jac.o_res.copyTo(r.data());
+    double sum = 0.0;
+    for(const double v : r) sum += v*v;
+    res.resL2 = std::sqrt(sum);
+}
+
+/* ====================================================================== */
+/* Output                                                                 */
+/* ====================================================================== */
+static void writeJSON(const std::string &file,Platform &gpu,int warmup,int reps,
+                      const std::vector<StreamResult> &stream,const std::vector<Result> &results){
+    FILE *fp = fopen(file.c_str(),"w");
+    if(!fp){
+        printf("\x1B[1;31mERROR: could not write %s\x1B[0m\n",file.c_str());
+        exit(1);
+    }
+
+    char host[MPI_MAX_PROCESSOR_NAME];
+    int len;
+    MPI_Get_processor_name(host,&len);
+    char date[64];
+    const time_t now = time(nullptr);
+    strftime(date,sizeof(date),"%Y-%m-%dT%H:%M:%S",localtime(&now));
+
+    fprintf(fp,"{\n");
+    fprintf(fp,"  \"date\": %s,\n",jsonString(date).c_str());
+    fprintf(fp,"  \"host\": %s,\n",jsonString(host).c_str());
+    fprintf(fp,"  \"mode\": %s,\n",jsonString(gpu.device.mode()).c_str());
+    fprintf(fp,"  \"arch\": %s,\n",jsonString(gpu.device.arch()).c_str());
+    fprintf(fp,"  \"warmup\": %d,\n",warmup);
+    fprintf(fp,"  \"reps\": %d,\n",reps);
+
+    fprintf(fp,"  \"stream\": [");
+    for(size_t k = 0; k < stream.size(); ++k){
+        const StreamResult &s = stream[k];
+        fprintf(fp,"%s\n    {\"kernel\": %s, \"bytes\": %.0f, ",k ? ",":"",jsonString(s.kernel).c_str(),s.bytes);
+        jsonStats(fp,s.time);
+        fprintf(fp,", \"gbs\": %.4f, \"best_gbs\": %.4f}",gbs(s.bytes,s.time.median),gbs(s.bytes,s.time.min));
+    }
+    fprintf(fp,"%s],\n",stream.empty() ? "":"\n  ");
+
+    fprintf(fp,"  \"results\": [");
+    for(size_t i = 0; i < results.size(); ++i){
+        const Result &r = results[i];
+        fprintf(fp,"%s\n    {\"dataset\": %s, \"variant\": %s, \"options\": %s,\n",
+                i ? ",":"",jsonString(r.dataset).c_str(),jsonString(r.variant).c_str(),jsonString(r.settings).c_str());
+        fprintf(fp,"     \"nvar\": %d, \"iters\": %d, \"nelem\": %d, \"nline\": %d, \"setup_s\": %.6f, \"res_l2\": %.9e,\n",
+                r.nvar,r.iters,r.nelem,r.nline,r.setup,r.resL2);
+        for(int p = 0; p < NUM_PHASES; ++p){
+            fprintf(fp,"     %s: {",jsonString(phase_names[p]).c_str());
+            jsonStats(fp,r.time[p]);
+            fprintf(fp,", \"bytes\": %.0f, \"gbs\": %.4f},\n",r.bytes[p],gbs(r.bytes[p],r.time[p].median));
+        }
+        fprintf(fp,"     \"wall\": {");
+        jsonStats(fp,r.wall);
+        fprintf(fp,"}}");
+    }
+    fprintf(fp,"%s]\n}\n",results.empty() ? "":"\n  ");
+    fclose(fp);
+}
+
+static void writeCSV(const std::string &file,const std::vector<StreamResult> &stream,
+                     const std::vector<Result> &results){
+    FILE *fp = fopen(file.c_str(),"w");
+    if(!fp){
+        printf("\x1B[1;31mERROR: could not write %s\x1B[0m\n",file.c_str());
+        exit(1);
+    }
+
+    /* device reference: best STREAM triad */
+    double peak = 0.0;
+    for(const StreamResult &s : stream){
+        if(s.kernel == "triad") peak = gbs(s.bytes,s.time.min);
+    }
+
+    fprintf(fp,"dataset,variant,nvar,iters,phase,median_s,p10_s,p90_s,min_s,max_s,bytes,gbs,frac_stream\n");
+    for(const StreamResult &s : stream){
+        fprintf(fp,"stream,%s,0,0,stream,%.9e,%.9e,%.9e,%.9e,%.9e,%.0f,%.4f,%.4f\n",
+                s.kernel.c_str(),s.time.median,s.time.p10,s.time.p90,s.time.min,s.time.max,s.bytes,
+                gbs(s.bytes,s.time.median),(peak > 0.0) ? gbs(s.bytes,s.time.median)/peak:0.0);
+    }
+    for(const Result &r : results){
+        for(int p = 0; p < NUM_PHASES; ++p){
+            const Stats &s = r.time[p];
+            const double rate = gbs(r.bytes[p],s.median);
+            fprintf(fp,"%s,%s,%d,%d,%s,%.9e,%.9e,%.9e,%.9e,%.9e,%.0f,%.4f,%.4f\n",
+                    r.dataset.c_str(),r.variant.c_str(),r.nvar,r.iters,phase_names[p],
+                    s.median,s.p10,s.p90,s.min,s.max,r.bytes[p],rate,(peak > 0.0) ? rate/peak:0.0);
+        }
+    }
+    fclose(fp);
+}
+
+int main(int argc,char **argv){
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-help" || arg == "-h"){
+            std::cout << "Usage: ./triblock_bench.exe [key=value]\n"
+                         "  mode=<m>             compute mode, as in triblock.exe (default: 0)\n"
+                         "  device_id=<id>       device ID on node (default: 0)\n"
+                         "  data=<dir,...>       dataset directories with gpuline.data.tbk or the\n"
+                         "                       gpuline.{mesh,jacobian}.data.bin pair, or gen for a synthetic\n"
+                         "                       system from the gen_* options of triblock.exe (default: .)\n"
+                         "  variants=<name,...>  kernel variants (default: default,generic,batched,schedule,\n"
+                         "                       fused,lowmem,fp32; all: every built-in variant)\n"
+                         "  variant.<name>=<k=v,...> define a variant by its solver options\n"
+                         "  nvar=<n,...>         block sizes (default: 9)\n"
+                         "  iters=<n,...>        line-Jacobi sweeps per timed run (default: 30)\n"
+                         "  warmup=N, reps=N     untimed and timed runs per point (default: 2, 10)\n"
+                         "  stream=0|1           STREAM-style device bandwidth probe (default: 1)\n"
+                         "  stream_mb=N          probe array size in MB (default: 256)\n"
+                         "  json=F, csv=F        output files (default: triblock_bench.json/.csv)\n"
+                         "  other key=value      solver options for every variant (e.g. vec_block=512)\n"
+                         "Built-in variants:\n";
+            for(int v = 0; v < Variants::count(); ++v){
+                printf("  %-10s %s\n",Variants::name(v),Variants::settings(v));
+            }
+            return 0;
+        }
+    }
+
+    MPI_Init(&argc,&argv);
+    Options opts(argc,argv);
+
+    const int mode      = opts.getInt("mode",SERIAL_MODE);
+    const int device_id = opts.getInt("device_id",0);
+    const int warmup    = opts.getInt("warmup",2);
+    const int reps      = std::max(1,opts.getInt("reps",10));
+    const std::vector<std::string> datasets = opts.getList("data",".");
+    const std::vector<int> nvars = opts.getIntList("nvar","9");
+    const std::vector<int> iterList = opts.getIntList("iters","30");
+    const std::string json = opts.getString("json","triblock_bench.json");
+    const std::string csv  = opts.getString("csv","triblock_bench.csv");
+
+    const std::vector<std::string> variants =
+        Variants::list(opts,"variants","default,generic,batched,schedule,fused,lowmem,fp32");
+    std::vector<std::string> settings(variants.size());
+    for(size_t v = 0; v < variants.size(); ++v){
+        if(!Variants::lookup(opts,variants[v],settings[v])){
+            printf("\x1B[1;31mERROR: unknown variant '%s' (see --help)\x1B[0m\n",variants[v].c_str());
+            exit(1);
+        }
+        if(Variants::merge(opts,settings[v]).getInt("line_order",0) > 0){
+            printf("\x1B[1;31mERROR: variant '%s': line_order reorders the shared mesh; use triblock.exe\x1B[0m\n",
+                   variants[v].c_str());
+            exit(1);
+        }
+    }
+
+    Platform gpu(MPI_COMM_WORLD,mode,device_id);
+    if(gpu.nrank > 1){
+        printf("\x1B[1;31mERROR: triblock_bench.exe runs on a single MPI rank\x1B[0m\n");
+        exit(1);
+    }
+    Transfer xfer(gpu);
+
+    std::vector<StreamResult> stream;
+    if(opts.getInt("stream",1) && mode != NATIVE_MODE){
+        stream = streamProbe(gpu,(size_t) opts.getInt("stream_mb",256)*1024*1024,
+                             opts.getInt("vec_block",256),warmup,reps);
+    }
+
+    std::vector<Result> results;
+    for(const std::string &dir : datasets){
+        /* prefer the versioned format (see triblock_convert.exe) when present */
+        const std::string tbkFile = dir + "/" TRIBLOCK_FILE_NAME;
+        const bool tbk = (access(tbkFile.c_str(),R_OK) == 0);
+
+        /* synthetic system: generated in memory, blocks per NVAR */
+        const bool synth = (dir == "gen");
+        Generator gen(opts);
+
+        Mesh mesh;
+        if(synth){
+            gen.generateMesh();
+            gen.toMesh(mesh);
+        } else {
+            tbk ? mesh.fromFile(tbkFile):mesh.fromFile(dir + "/gpuline.mesh.data.bin");
+        }
+        mesh.setupDevice(gpu);
+        mesh.toDevice(xfer);
+        xfer.finish();
+
+        for(const int nvar : nvars){
+            if(synth) gen.generateBlocks(nvar);
+
+            for(size_t v = 0; v < variants.size(); ++v){
+                const Options vopts = Variants::merge(opts,settings[v]);
+
+                /* fresh blocks per variant: lowmem and nrhs change the layout */
+                Jacobian Jac;
+                if(synth){
+                    gen.toJacobian(Jac);
+                } else {
+                    tbk ? Jac.fromFile(mesh.nlineelem,tbkFile):
+                          Jac.fromFile(mesh.nlineelem,dir + "/gpuline.jacobian.data.bin");
+                }
+                if(Jac.nelem != mesh.nelem || Jac.nintface != mesh.nintface){
+                    printf("\x1B[1;31mERROR: %s: Jacobian and mesh sizes do not match\x1B[0m\n",dir.c_str());
+                    exit(1);
+                }
+                Jac.resizeBlockSize(nvar);
+                Jac.assembleTriBlocks(mesh);
+                const int nrhs = vopts.getInt("nrhs",1);
+                if(nrhs > 1) Jac.setNrhs(nrhs,Generator::batchRhs(Jac,nrhs).data());
+                Jac.lowmem = vopts.getInt("lowmem",0);
+                Jac.setupDevice(gpu);
+                Jac.toDevice(xfer);
+                xfer.finish();
+                const std::vector<double> U0(Jac.U.begin(),Jac.U.end());
+
+                LineSolver solver(gpu,mesh,Jac,vopts);
+                double t1 = MPI_Wtime();
+                solver.setup();
+                double setup = MPI_Wtime() - t1;
+
+                for(const int iters : iterList){
+                    Result res;
+                    res.dataset  = synth ? gen.name():baseName(dir);
+                    res.variant  = variants[v];
+                    res.settings = settings[v];
+                    res.nvar  = nvar;
+                    res.iters = iters;
+                    res.nelem = mesh.nelem;
+                    res.nline = mesh.nline;
+                    res.setup = setup;
+                    benchPoint(gpu,Jac,solver,iters,warmup,reps,U0,res);
+
+                    printf("%-8s %-10s nvar=%-3d iters=%-4d factor %10.6f s %8.2f GB/s | sweep %10.6f s "
+                           "[p10 %10.6f, p90 %10.6f] %8.2f GB/s | ||r|| %.6e\n",
+                           res.dataset.c_str(),res.variant.c_str(),nvar,iters,
+                           res.time[0].median,gbs(res.bytes[0],res.time[0].median),
+                           res.time[4].median,res.time[4].p10,res.time[4].p90,
+                           gbs(res.bytes[4],res.time[4].median),res.resL2);
+                    results.push_back(res);
+                }
+            }
+        }
+    }
+
+    writeJSON(json,gpu,warmup,reps,stream,results);
+    writeCSV(csv,stream,results);
+    printf("results: %s, %s\n",json.c_str(),csv.c_str());
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * File:   triblock_convert.cxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ *
+ * Converts the legacy Fortran stream files (gpuline.mesh.data.bin and
+ * gpuline.jacobian.data.bin) into the versioned TriBlock format.
+ */
+
+/* header files */
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "TriBlockFile.hxx"
+
+/* ============================================================== */
+/* Renumber elements (and faces) so that line elements are stored */
+/* contiguously in line order: lines[m] == m after renumbering.   */
+/* ============================================================== */
+static void lineOrder(Mesh &mesh,Jacobian &Jac,bool packA,
+                      std::vector<int> &elemperm){
+    const int nelem = mesh.nelem;
+    const int nface = mesh.nintface;
+    const size_t nblk = (size_t) Jac.nvar*Jac.nvar;
+    const size_t nv = Jac.nvar;
+
+    /* element permutation: new -> old */
+    std::vector<int> ielem(nelem,-1);
+    elemperm.clear();
+    for(int m = 0; m < mesh.nlineelem; ++m){
+        const int e = mesh.lines[m];
+        if(ielem[e] < 0){ielem[e] = elemperm.size(); elemperm.push_back(e);}
+    }
+    for(int e = 0; e < nelem; ++e){
+        if(ielem[e] < 0){ielem[e] = elemperm.size(); elemperm.push_back(e);}
+    }
+
+    /* face permutation: line faces first in line order */
+    std::vector<int> iface(nface,-1);
+    std::vector<int> faceperm;
+    for(int l = 0; l < mesh.nline; ++l){
+        for(int k = 1; k < mesh.linesize[l]; ++k){
+            const int f = mesh.lineface[mesh.linepoint[l] + k];
+            if(f >= 0 && iface[f] < 0){iface[f] = faceperm.size(); faceperm.push_back(f);}
+        }
+    }
+    for(int f = 0; f < nface; ++f){
+        if(iface[f] < 0){iface[f] = faceperm.size(); faceperm.push_back(f);}
+    }
+
+    /* mesh connectivity */
+    std::vector<int> epoint(nelem+1),ef;
+    ef.reserve(mesh.eftot);
+    for(int e = 0; e < nelem; ++e){
+        const int old = elemperm[e];
+        epoint[e] = ef.size();
+        for(int k = mesh.epoint[old]; k < mesh.epoint[old+1]; ++k){
+            const int f = mesh.ef[k];
+            ef.push_back((f >= 0) ? iface[f]:f);
+        }
+    }
+    epoint[nelem] = ef.size();
+
+    std::vector<int> fc(2*nface);
+    for(int f = 0; f < nface; ++f){
+        fc[2*f+0] = ielem[mesh.fc[2*faceperm[f]+0]];
+        fc[2*f+1] = ielem[mesh.fc[2*faceperm[f]+1]];
+    }
+
+    for(int m = 0; m < mesh.nlineelem; ++m){
+        const int f = mesh.lineface[m];
+        mesh.lines[m] = ielem[mesh.lines[m]];
+        mesh.lineface[m] = (f >= 0) ? iface[f]:f;
+    }
+    memcpy(mesh.epoint.data(),epoint.data(),epoint.size()*sizeof(int));
+    memcpy(mesh.ef.data(),ef.data(),ef.size()*sizeof(int));
+    memcpy(mesh.fc.data(),fc.data(),fc.size()*sizeof(int));
+
+    /* Jacobian blocks and vectors */
+    std::vector<double> jacD(Jac.jacD.size()),jacO1(Jac.jacO1.size()),jacO2(Jac.jacO2.size());
+    std::vector<double> rhs(Jac.rhs.size()),U0(Jac.U0.size()),A(Jac.A.size());
+    for(int e = 0; e < nelem; ++e){
+        const size_t old = elemperm[e];
+        memcpy(&jacD[nblk*e],&Jac.jacD[nblk*old],nblk*sizeof(double));
+        memcpy(&rhs[nv*e],&Jac.rhs[nv*old],nv*sizeof(double));
+        memcpy(&U0[nv*e],&Jac.U0[nv*old],nv*sizeof(double));
+        if(packA && nblk*(e+1) <= A.size()){
+            memcpy(&A[nblk*e],&Jac.A[nblk*old],nblk*sizeof(double));
+        }
+    }
+    for(int f = 0; f < nface; ++f){
+        const size_t old = faceperm[f];
+        memcpy(&jacO1[nblk*f],&Jac.jacO1[nblk*old],nblk*sizeof(double));
+        memcpy(&jacO2[nblk*f],&Jac.jacO2[nblk*old],nblk*sizeof(double));
+    }
+    memcpy(Jac.jacD.data(),jacD.data(),jacD.size()*sizeof(double));
+    memcpy(Jac.jacO1.data(),jacO1.data(),jacO1.size()*sizeof(double));
+    memcpy(Jac.jacO2.data(),jacO2.data(),jacO2.size()*sizeof(double));
+    memcpy(Jac.rhs.data(),rhs.data(),rhs.size()*sizeof(double));
+    memcpy(Jac.U0.data(),U0.data(),U0.size()*sizeof(double));
+    if(packA) memcpy(Jac.A.data(),A.data(),A.size()*sizeof(double));
+}
+
+int main(int argc,char **argv){
+    std::string meshName = "gpuline.mesh.data.bin";
+    std::string jacName = "gpuline.jacobian.data.bin";
+    std::string outName = TRIBLOCK_FILE_NAME;
+    bool packA = false;
+    bool lineOrdered = false;
+
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-help" || arg == "-h"){
+            std::cout << "Usage: ./triblock_convert.exe [OPTION]\n"
+                         "  mesh=<file>     legacy mesh file     (default: gpuline.mesh.data.bin)\n"
+                         "  jac=<file>      legacy Jacobian file (default: gpuline.jacobian.data.bin)\n"
+                         "  out=<file>      TriBlock output file (default: " TRIBLOCK_FILE_NAME ")\n"
+                         "  --pack          store precomputed tri-block A (assembleTriBlocks)\n"
+                         "  --line-order    renumber elements/faces into line order\n";
+            return 0;
+        } else
+        if(arg.compare(0,5,"mesh=") == 0){meshName = arg.substr(5);} else
+        if(arg.compare(0,4,"jac=") == 0){jacName = arg.substr(4);} else
+        if(arg.compare(0,4,"out=") == 0){outName = arg.substr(4);} else
+        if(arg == "--pack"){packA = true;} else
+        if(arg == "--line-order"){lineOrdered = true;}
+        else {
+            printf("\x1B[1;31mUnknown option: %s\x1B[0m\n",arg.c_str());
+            return 1;
+        }
+    }
+
+    /* read legacy data */
+    Mesh mesh;
+    mesh.fromFile(meshName);
+
+    Jacobian Jac;
+    Jac.fromFile(mesh.nlineelem,jacName);
+    if(Jac.nelem != mesh.nelem || Jac.nintface != mesh.nintface){
+        printf("\x1B[1;31mERROR: Jacobian and mesh sizes do not match\x1B[0m\n");
+        return 1;
+    }
+    if(packA) Jac.assembleTriBlocks(mesh);
+
+    /* promote mapped views to owned storage before renumbering in place */
+    std::vector<int> elemperm;
+    if(lineOrdered){
+        Jac.jacD.resize(Jac.jacD.size());
+        Jac.jacO1.resize(Jac.jacO1.size());
+        Jac.jacO2.resize(Jac.jacO2.size());
+        Jac.rhs.resize(Jac.rhs.size());
+        Jac.U0.resize(Jac.U0.size());
+        lineOrder(mesh,Jac,packA,elemperm);
+    }
+
+    /* assemble header and section table */
+    TriBlockHeader hdr;
+    memset(&hdr,0,sizeof(hdr));
+    hdr.flags = (packA ? TRIBLOCK_FLAG_PACKED_A:0)
+              | (lineOrdered ? TRIBLOCK_FLAG_LINE_ORDER:0);
+    hdr.nvar = Jac.nvar;
+    hdr.nelem = mesh.nelem;
+    hdr.nintface = mesh.nintface;
+    hdr.eftot = mesh.eftot;
+    hdr.nline = mesh.nline;
+    hdr.nlineelem = mesh.nlineelem;
+    hdr.max_line_nelem = mesh.max_line_nelem;
+
+    const void *data[SEC_COUNT] = {nullptr};
+    size_t bytes[SEC_COUNT] = {0};
+    auto add = [&](int id,const void *ptr,size_t nbytes){data[id] = ptr; bytes[id] = nbytes;};
+
+    add(SEC_EPOINT,   mesh.epoint.data(),   mesh.epoint.size()*sizeof(int));
+    add(SEC_EF,       mesh.ef.data(),       mesh.ef.size()*sizeof(int));
+    add(SEC_FC,       mesh.fc.data(),       mesh.fc.size()*sizeof(int));
+    add(SEC_LINESIZE, mesh.linesize.data(), mesh.linesize.size()*sizeof(int));
+    add(SEC_LINEPOINT,mesh.linepoint.data(),mesh.linepoint.size()*sizeof(int));
+    add(SEC_LINES,    mesh.lines.data(),    mesh.lines.size()*sizeof(int));
+    add(SEC_LINEFACE, mesh.lineface.data(), mesh.lineface.size()*sizeof(int));
+    add(SEC_JACD,     Jac.jacD.data(),      Jac.jacD.size()*sizeof(double));
+    add(SEC_JACO1,    Jac.jacO1.data(),     Jac.jacO1.size()*sizeof(double));
+    add(SEC_JACO2,    Jac.jacO2.data(),     Jac.jacO2.size()*sizeof(double));
+    add(SEC_RHS,      Jac.rhs.data(),       Jac.rhs.size()*sizeof(double));
+    add(SEC_U0,       Jac.U0.data(),        Jac.U0.size()*sizeof(double));
+    if(packA)       add(SEC_A,Jac.A.data(),Jac.A.size()*sizeof(double));
+    if(lineOrdered) add(SEC_ELEMPERM,elemperm.data(),elemperm.size()*sizeof(int));
+
+    printf("\x1B[1;92mWriting %s\x1B[0m\n",outName.c_str());
+    if(!TriBlockFile::write(outName,hdr,data,bytes)) return 1;
+
+    /* read back and verify checksums */
+    MappedFile file;
+    TriBlockFile tbk;
+    if(!file.open(outName) || !tbk.read(file,TRIBLOCK_SECTIONS_ALL)) return 1;
+    printf("Wrote TriBlock v%d file: %.2f MB\n",tbk.header.version,file.size()/1024./1024.);
+    return 0;
+}
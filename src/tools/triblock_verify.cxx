@@ -0,0 +1,172 @@
+/**
+ * File:   triblock_verify.cxx
+ * Author: akirby
+ *
+ * Created on October 17, 2026
+ *
+ * Verification driver: runs every kernel variant x NVAR x dataset in
+ * lockstep with the host port of the Fortran line smoother (Reference)
+ * and compares dU, U and res after every sweep. line_order variants run
+ * on a reordered copy of the mesh and are compared in native element
+ * order, so they also check Mesh::toNative/fromNative. Prints one PASS/FAIL
+ * line per point and exits with status 1 if any point fails, so it can
+ * gate kernel changes in CI.
+ */
+
+/* header files */
+#include "Platform.hxx"
+#include "Mesh.hxx"
+#include "Jacobian.hxx"
+#include "TriBlockFile.hxx"
+#include "Generator.hxx"
+#include "Transfer.hxx"
+#include "LineSolver.hxx"
+#include "Reference.hxx"
+#include "Variants.hxx"
+#include "Options.hxx"
+
+int main(int argc,char **argv){
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-help" || arg == "-h"){
+            std::cout << "Usage: ./triblock_verify.exe [key=value]\n"
+                         "  mode=<m>             compute mode, as in triblock.exe (default: 0)\n"
+                         "  device_id=<id>       device ID on node (default: 0)\n"
+                         "  data=<dir,...>       dataset directories, or gen for a synthetic system (default: .)\n"
+                         "  variants=<name,...>  kernel variants, as in triblock_bench.exe (default: all)\n"
+                         "  variant.<name>=<k=v,...> define a variant by its solver options\n"
+                         "  nvar=<n,...>         block sizes (default: 9)\n"
+                         "  iters=N              sweeps compared per point (default: 10)\n"
+                         "  verify_tol=X         error allowed per sweep (default by precision: fp64 1e-10,\n"
+                         "                       fp32 1e-4, fp16 1e-2, bf16 5e-2)\n"
+                         "  verbose=0|1          print the error of every sweep (default: 0)\n"
+                         "  other key=value      solver options for every variant\n"
+                         "Built-in variants:\n";
+            for(int v = 0; v < Variants::count(); ++v){
+                printf("  %-10s %s\n",Variants::name(v),Variants::settings(v));
+            }
+            return 0;
+        }
+    }
+
+    MPI_Init(&argc,&argv);
+    Options opts(argc,argv);
+
+    const int mode      = opts.getInt("mode",SERIAL_MODE);
+    const int device_id = opts.getInt("device_id",0);
+    const int iters     = opts.getInt("iters",10);
+    const int verbose   = opts.getInt("verbose",0);
+    const std::vector<std::string> datasets = opts.getList("data",".");
+    const std::vector<int> nvars = opts.getIntList("nvar","9");
+
+    const std::vector<std::string> variants = Variants::list(opts,"variants","all");
+    std::vector<std::string> settings(variants.size());
+    for(size_t v = 0; v < variants.size(); ++v){
+        if(!Variants::lookup(opts,variants[v],settings[v])){
+            printf("\x1B[1;31mERROR: unknown variant '%s' (see --help)\x1B[0m\n",variants[v].c_str());
+            exit(1);
+        }
+    }
+
+    Platform gpu(MPI_COMM_WORLD,mode,device_id);
+    if(gpu.nrank > 1){
+        printf("\x1B[1;31mERROR: triblock_verify.exe runs on a single MPI rank\x1B[0m\n");
+        exit(1);
+    }
+    Transfer xfer(gpu);
+
+    int npass = 0,nfail = 0,nskip = 0;
+    for(const std::string &dir : datasets){
+        const std::string tbkFile = dir + "/" TRIBLOCK_FILE_NAME;
+        const bool tbk = (access(tbkFile.c_str(),R_OK) == 0);
+        const bool synth = (dir == "gen");
+        Generator gen(opts);
+        if(synth) gen.generateMesh();
+
+        auto loadMesh = [&](Mesh &m){
+            if(synth){
+                gen.toMesh(m);
+            } else {
+                tbk ? m.fromFile(tbkFile):m.fromFile(dir + "/gpuline.mesh.data.bin");
+            }
+        };
+        auto loadJacobian = [&](Jacobian &J,Mesh &m,int nvar){
+            if(synth){
+                gen.toJacobian(J);
+            } else {
+                tbk ? J.fromFile(m.nlineelem,tbkFile):
+                      J.fromFile(m.nlineelem,dir + "/gpuline.jacobian.data.bin");
+            }
+            if(J.nelem != m.nelem || J.nintface != m.nintface){
+                printf("\x1B[1;31mERROR: %s: Jacobian and mesh sizes do not match\x1B[0m\n",dir.c_str());
+                exit(1);
+            }
+            J.resizeBlockSize(nvar);
+            J.assembleTriBlocks(m);
+        };
+
+        Mesh mesh;
+        loadMesh(mesh);
+        mesh.setupDevice(gpu);
+        mesh.toDevice(xfer);
+        xfer.finish();
+
+        for(const int nvar : nvars){
+            if(synth) gen.generateBlocks(nvar);
+
+            for(size_t v = 0; v < variants.size(); ++v){
+                const Options vopts = Variants::merge(opts,settings[v]);
+                const std::string label = (synth ? gen.name():dir) + " " + variants[v] +
+                                          " nvar=" + std::to_string(nvar);
+                if(vopts.getInt("nrhs",1) != 1){
+                    printf("%-40s SKIP (the reference solves one right-hand side)\n",label.c_str());
+                    ++nskip;
+                    continue;
+                }
+
+                Jacobian Jac;
+                loadJacobian(Jac,mesh,nvar);
+                const std::vector<double> U0(Jac.U.begin(),Jac.U.end());
+
+                /* line_order: the solver runs on reordered copies, the reference on Jac */
+                const int W = vopts.getInt("line_order",0);
+                Mesh lmesh;
+                Jacobian lJac;
+                if(W > 0){
+                    loadMesh(lmesh);
+                    loadJacobian(lJac,lmesh,nvar);
+                    lmesh.reorderLines(W);
+                    lJac.reorderLines(lmesh);
+                    lmesh.setupDevice(gpu);
+                    lmesh.toDevice(xfer);
+                }
+                Mesh &smesh = (W > 0) ? lmesh:mesh;
+                Jacobian &sJac = (W > 0) ? lJac:Jac;
+
+                sJac.lowmem = vopts.getInt("lowmem",0);
+                sJac.setupDevice(gpu);
+                sJac.toDevice(xfer);
+                xfer.finish();
+
+                LineSolver solver(gpu,smesh,sJac,vopts);
+                solver.setup();
+                solver.factor();
+
+                Reference ref(mesh,Jac);
+                ref.tol = Reference::tolerance(vopts);
+                const bool pass = ref.verify(solver,U0,iters);
+                pass ? ++npass:++nfail;
+
+                printf("%-40s %s  max err dU %.3e, U %.3e, res %.3e (tol %.1e/sweep)",label.c_str(),
+                       pass ? "\x1B[1;92mPASS\x1B[0m":"\x1B[1;31mFAIL\x1B[0m",
+                       ref.maxError(REF_DU),ref.maxError(REF_U),ref.maxError(REF_RES),ref.tol);
+                pass ? printf("\n"):printf(" first failure: sweep %d\n",ref.failIter);
+                if(verbose || !pass) ref.printHistory();
+            }
+        }
+    }
+
+    printf("verify: %d passed, %d failed, %d skipped\n",npass,nfail,nskip);
+    MPI_Finalize();
+    return (nfail > 0) ? 1:0;
+}
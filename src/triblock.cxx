@@ -0,0 +1,125 @@
+/**
+ * \file    triblock.cxx
+ * \author  akirby
+ *
+ * \brief C API (triblock.h) on TriBlockSolver
+ */
+
+/* header files */
+#include "triblock.h"
+#include "TriBlockSolver.hxx"
+#include "Convergence.hxx"
+
+struct triblock_s {
+    TriBlockSolver *solver;
+};
+
+static int invalid(triblock_t tb,const char *func){
+    if(tb && tb->solver) return 0;
+    printf("\x1B[1;31mERROR: %s: invalid triblock handle\x1B[0m\n",func);
+    return 1;
+}
+
+static int invalidLocation(int location,const char *func){
+    if(location == TRIBLOCK_HOST || location == TRIBLOCK_DEVICE) return 0;
+    printf("\x1B[1;31mERROR: %s: location must be TRIBLOCK_HOST or TRIBLOCK_DEVICE\x1B[0m\n",func);
+    return 1;
+}
+
+static int results(const TriBlockSolver *s,int *niter,double *resnorm){
+    if(niter) *niter = s->niter;
+    if(resnorm) *resnorm = s->resNorm;
+    return (s->status == CONV_DIVERGED) ? TRIBLOCK_ERROR:TRIBLOCK_SUCCESS;
+}
+
+extern "C" {
+
+int triblock_create(triblock_t *tb,int mode,int device_id,const char *options){
+    if(!tb) return TRIBLOCK_ERROR;
+
+    Options opts(options ? options:"");
+    *tb = new triblock_s;
+    (*tb)->solver = new TriBlockSolver(mode,device_id,opts);
+    return TRIBLOCK_SUCCESS;
+}
+
+int triblock_set_mesh(triblock_t tb,int nelem,int nintface,int eftot,
+                      const int *epoint,const int *ef,const int *fc,
+                      int nline,int nlineelem,const int *linesize,const int *linepoint,
+                      const int *lines,const int *lineface,int base){
+    if(invalid(tb,"triblock_set_mesh")) return TRIBLOCK_ERROR;
+    if(nelem < 0 || nintface < 0 || eftot < 0 || nline < 0 || nlineelem < 0 ||
+       !epoint || !ef || !fc || !linesize || !linepoint || !lines || !lineface){
+        printf("\x1B[1;31mERROR: triblock_set_mesh: negative size or NULL array\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+
+    return tb->solver->setMesh(nelem,nintface,eftot,epoint,ef,fc,
+                               nline,nlineelem,linesize,linepoint,lines,lineface,base);
+}
+
+int triblock_set_jacobian(triblock_t tb,int nvar,const double *D,const double *O1,
+                          const double *O2,const double *rhs,int location){
+    if(invalid(tb,"triblock_set_jacobian")) return TRIBLOCK_ERROR;
+    if(invalidLocation(location,"triblock_set_jacobian")) return TRIBLOCK_ERROR;
+    if(nvar <= 0 || !D || !O1 || !O2 || !rhs){
+        printf("\x1B[1;31mERROR: triblock_set_jacobian: nvar <= 0 or NULL array\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+
+    return tb->solver->setJacobian(nvar,D,O1,O2,rhs,location);
+}
+
+int triblock_set_rhs(triblock_t tb,int nrhs,const double *rhs){
+    if(invalid(tb,"triblock_set_rhs")) return TRIBLOCK_ERROR;
+    if(nrhs < 1 || !rhs){
+        printf("\x1B[1;31mERROR: triblock_set_rhs: nrhs < 1 or NULL array\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+
+    return tb->solver->setRhs(nrhs,rhs);
+}
+
+int triblock_factor(triblock_t tb){
+    if(invalid(tb,"triblock_factor")) return TRIBLOCK_ERROR;
+
+    return tb->solver->factor();
+}
+
+int triblock_solve(triblock_t tb,double *U,int location,int *niter,double *resnorm){
+    if(invalid(tb,"triblock_solve")) return TRIBLOCK_ERROR;
+    if(invalidLocation(location,"triblock_solve")) return TRIBLOCK_ERROR;
+    if(!U) return TRIBLOCK_ERROR;
+
+    if(tb->solver->solve(U,location)) return TRIBLOCK_ERROR;
+    return results(tb->solver,niter,resnorm);
+}
+
+int triblock_destroy(triblock_t *tb){
+    if(!tb || !*tb) return TRIBLOCK_ERROR;
+
+    delete (*tb)->solver;
+    delete *tb;
+    *tb = nullptr;
+    return TRIBLOCK_SUCCESS;
+}
+
+} /* extern "C" */
+
+int triblock_set_jacobian_occa(triblock_t tb,int nvar,occa::memory &o_D,occa::memory &o_O1,
+                               occa::memory &o_O2,occa::memory &o_rhs){
+    if(invalid(tb,"triblock_set_jacobian_occa")) return TRIBLOCK_ERROR;
+    if(nvar <= 0){
+        printf("\x1B[1;31mERROR: triblock_set_jacobian_occa: nvar <= 0\x1B[0m\n");
+        return TRIBLOCK_ERROR;
+    }
+
+    return tb->solver->setJacobian(nvar,o_D,o_O1,o_O2,o_rhs);
+}
+
+int triblock_solve_occa(triblock_t tb,occa::memory &o_U,int *niter,double *resnorm){
+    if(invalid(tb,"triblock_solve_occa")) return TRIBLOCK_ERROR;
+
+    if(tb->solver->solve(o_U)) return TRIBLOCK_ERROR;
+    return results(tb->solver,niter,resnorm);
+}